@@ -0,0 +1,35 @@
+/// \brief Semi-Lagrangian advection kernel (AVX2 8-wide with a scalar fallback)
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef ADVECT_KERNEL_H_
+#define ADVECT_KERNEL_H_
+
+#include "GridLayout.h"
+
+class AdvectKernel
+{
+    public:
+        // Components per cell in interleaved fields
+        static const int INTERLEAVED_WIDTH = 4;
+
+        // Advects _count fields (_d[n] from _d0[n]) over the interior cells of _layout,
+        // computing the backtrace through (_xVel, _yVel) once and sharing it between every field.
+        // Boundary cells are left for the caller to fix up with SetBounds.
+        static void Advect(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep,
+                           float* const* _d, const float* const* _d0, int _count);
+
+        // Advects an interleaved field (INTERLEAVED_WIDTH components per cell, _d from _d0) with one backtrace
+        // and one load of all components per bilinear tap
+        static void AdvectInterleaved(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep,
+                                      float* _d, const float* _d0);
+
+        // True when built with AVX2 / FMA enabled
+        static bool IsVectorised();
+};
+
+#endif // _ADVECT_KERNEL_H_
@@ -0,0 +1,34 @@
+/// \brief Headless solver benchmark, compares memory layouts by throughput and cache misses
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "GridLayout.h"
+
+#include <vector>
+
+class Benchmark
+{
+    public:
+        Benchmark(int _frames);
+
+        void Run();
+        // 3D solver at 64^3 - 256^3
+        void RunVolume();
+
+    private:
+        void RunCase(MemoryLayout _layout, int _gridDimensions);
+        void RunVolumeCase(int _gridDimensions);
+
+        int m_frames;
+        std::vector<int> m_gridSizes = {128, 256, 512, 1024};
+        std::vector<int> m_volumeSizes = {64, 128, 256};
+};
+
+#endif // _BENCHMARK_H_
@@ -11,17 +11,72 @@
 
 #include <SDL2/SDL.h>
 
+#include "GridLayout.h"
+#include "Obstacles.h"
+#include "Snapshot.h"
 #include "Texture.h"
 
+#include <chrono>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+// Field advected by Fluid::AdvectFields, _d is written from _d0 then bounded with SetBounds(b)
+struct AdvectTarget
+{
+    int b;
+    std::vector<float>* d;
+    std::vector<float>* d0;
+};
+
+// Gaussian source for Fluid::AddSplats, positions and radius in screen pixels. Full strength at the centre,
+// falling to nothing at the radius
+struct Splat
+{
+    float x;
+    float y;
+    float radius;
+    float density;
+    float xVel;
+    float yVel;
+    int32_t species;    // Receives density as well, -1 for none
+};
+
+// Steps of Fluid::Update, timed in FluidStats
+enum class SolverStage
+{
+    VelocityDiffuse,
+    VelocityProject,
+    VelocityAdvect,
+    VelocityReproject,
+    DensityDiffuse,
+    DensityAdvect,
+    Species,
+    Count
+};
+
+// Solver statistics for the last Update, only gathered while Fluid::SetStatsEnabled is on
+struct FluidStats
+{
+    double stageMs[int(SolverStage::Count)];
+    int gridDimensions;
+    int iterations;             // Gauss-Seidel iterations per solve
+    float pressureResidual;     // RMS residual of the final pressure solve
+    float totalDensity;
+    float maxVelocity;          // Cells per unit time
+    float divergence;           // RMS divergence of the final velocity field
+};
+
 class Fluid
 {
     public:
-        Fluid(int _screenDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer);
+        Fluid(int _screenDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer, MemoryLayout _layout = MemoryLayout::RowMajor);
 
         void AddDensity(int _xPos, int _yPos, float _amount);
         void AddVelocity(int _xPos, int _yPos, float _amountX, float _amountY);
+        // Applies many splats in one pass. Splats are binned by the 8x8 tiles they overlap, then each touched
+        // tile is visited once and sums every splat in its bin (density is constrained to 255 afterwards)
+        void AddSplats(const Splat* _splats, size_t _count);
 
         // The following functions have been implemented and ported from:
         // Stam, Jos., 2003. Real-Time Fluid Dynamics for Games. [online]
@@ -34,26 +89,95 @@ class Fluid
         void SetBounds(int _b, std::vector<float>& _x, int _gridDimensions);
         // [End of reference]
 
+        // Advects several fields through one shared backtrace
+        void AdvectFields(AdvectTarget* _targets, int _count, std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions);
+
+        // Dye species, m_MAX_SPECIES scalars interleaved per cell so every species shares one sweep,
+        // one backtrace and one neighbourhood load. Passive, like density (bounded as _b = 0).
+        void SetSpeciesCount(int _count);
+        int GetSpeciesCount();
+        void AddSpecies(int _xPos, int _yPos, int _species, float _amount);
+        void DiffuseSpecies(std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timestep, int _iterations, int _gridDimensions);
+        void LinearSolveSpecies(std::vector<float>& _x, std::vector<float>& _xPrev, float _a, float _c, int _iterations, int _gridDimensions);
+        void AdvectSpecies(std::vector<float>& _d, std::vector<float>& _d0, std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions);
+        void SetSpeciesBounds(std::vector<float>& _x, int _gridDimensions);
+        const std::vector<float>& GetSpecies();
+
         void Fade(float _fadeRate);
         void ShowGrid();
         void ShowVelocity();
 
         void Update();
+        // White density, or the species in colour (one streaming texture upload) when there are any
         void Draw();
         void ChangeResolution(bool _scale);
         void Reset();
         void Destroy();
 
+        // Full solver state (grid, parameters, density and velocity), see Snapshot.h for the format
+        bool SaveSnapshot(std::string _path);
+        bool LoadSnapshot(std::string _path);
+        // From a snapshot file's bytes held in memory (the startup snapshot embedded in an input journal), _name is used in messages
+        bool LoadSnapshot(const std::vector<uint8_t>& _data, std::string _name);
+
+        // Solid obstacles, positions are in screen pixels. Changes are compiled at the start of the next Update
+        bool LoadObstacles(std::string _path);
+        void PaintObstacle(int _xPos, int _yPos, int _radius, bool _solid);
+
         int GetGridIndex(int _xPos, int _yPos);
+        MemoryLayout GetMemoryLayout();
+        const GridLayout& GetGridLayout();
+        int GetGridDimensions();
+        const std::vector<float>& GetDensity();
+        const std::vector<float>& GetXVelocity();
+        const std::vector<float>& GetYVelocity();
+        // FNV-1a hash of the density and velocity bits, equal hashes mean bit-identical state
+        uint64_t GetStateHash();
+
+        // Statistics cost a few passes over the grid, so they are off unless asked for
+        void SetStatsEnabled(bool _enabled);
+        const FluidStats& GetStats();
+
+        // Replaces the grid and fields wholesale (recording playback), velocity is zeroed when not given
+        void SetState(int _gridDimensions, MemoryLayout _layout, const std::vector<float>& _density, const std::vector<float>* _xVel, const std::vector<float>* _yVel);
+
+        static constexpr int m_MAX_SPECIES = 4;
 
     private:
+        void DrawSpecies();
+        // Validates an opened snapshot against this window and takes its grid and fields
+        bool AdoptSnapshot(Snapshot& _snapshot, std::string _name);
+        void EndStage(SolverStage _stage);
+        void CollectStats();
+
+        // Splat scratch, in grid cells
+        struct SplatSource
+        {
+            float x;
+            float y;
+            float radiusSquared;
+            float falloff;      // 1 / (2 sigma^2)
+            float density;
+            float xVel;
+            float yVel;
+            int species;
+        };
+        std::vector<SplatSource> m_splatSources;
+        std::vector<std::vector<int>> m_splatBins;
+        std::vector<int> m_touchedTiles;
+
         int m_screenDimensions;
         int m_cellSize = 32;
         int m_scaleFactor = 5;
+        static constexpr int m_MAX_ADVECT_TARGETS = 8;
+        static const int m_SOLVER_ITERATIONS = 4;
         int m_gridDimensions;
         float m_timeStep;
         float m_diffusion;
         float m_viscosity;
+
+        // Maps (x, y) onto field storage, shared by every field below
+        GridLayout m_layout;
         
         // Density
         std::vector<float> m_prevDensity;
@@ -65,8 +189,22 @@ class Fluid
         std::vector<float> m_xVel;
         std::vector<float> m_yVel;
 
+        // Species (m_MAX_SPECIES floats per cell, unused ones stay 0)
+        int m_speciesCount = 0;
+        std::vector<float> m_speciesPrev;
+        std::vector<float> m_species;
+
+        Obstacles m_obstacles;
+
+        bool m_statsEnabled = false;
+        FluidStats m_stats = {};
+        std::chrono::steady_clock::time_point m_stageStart;
+
         SDL_Renderer* m_renderer;
         Texture m_arrow;
+        SDL_Texture* m_speciesTexture = NULL;
+        std::vector<Uint32> m_speciesPixels;
+        int m_textureDimensions = 0;
 };
 
 #endif  // _FLUID_H_
\ No newline at end of file
@@ -0,0 +1,93 @@
+/// \brief Volumetric (3D) variant of Fluid with cache-blocked, multithreaded kernels
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef FLUID_3D_H_
+#define FLUID_3D_H_
+
+#include <SDL2/SDL.h>
+
+#include "ThreadPool.h"
+
+#include <vector>
+
+class Fluid3D
+{
+    public:
+        Fluid3D(int _gridDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer, int _threads = 0);
+
+        // Same stepping API as Fluid, positions are in grid cells
+        void AddDensity(int _xPos, int _yPos, int _zPos, float _amount);
+        void AddVelocity(int _xPos, int _yPos, int _zPos, float _amountX, float _amountY, float _amountZ);
+
+        // 3D extension of the Stam solver (7-point stencil, three velocity components).
+        // Gauss-Seidel runs red-black so each colour can be split across threads, and every sweep walks
+        // z inside blocks of rows so the three planes a stencil touches stay in cache.
+        void Diffuse(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timeStep, int _iterations);
+        void LinearSolve(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _a, float _c, int _iterations);
+        void Project(std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _zVel, std::vector<float>& _p, std::vector<float>& _div, int _iterations);
+        // Advects _count fields (_d[n] from _d0[n]) through one shared backtrace, bounded with SetBounds(_b[n])
+        void Advect(const int* _b, std::vector<float>* const* _d, std::vector<float>* const* _d0, int _count,
+                    std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _zVel, float _timeStep);
+        void SetBounds(int _b, std::vector<float>& _x);
+
+        void Fade(float _fadeRate);
+        void Update();
+        // Renders a max-projection along z, or the slice at GetSlice()
+        void Draw();
+        void Reset();
+        void Destroy();
+
+        void SetMaxProjection(bool _maxProjection);
+        bool GetMaxProjection();
+        void SetSlice(int _slice);
+        int GetSlice();
+
+        // No bounds checking, used by the kernels
+        int GetGridIndex(int _xPos, int _yPos, int _zPos);
+        // Positions outside the grid are clamped to the nearest edge cell
+        int GetClampedIndex(int _xPos, int _yPos, int _zPos);
+        int GetGridDimensions();
+        int GetThreadCount();
+        const std::vector<float>& GetDensity();
+
+    private:
+        // Runs _func(z, yBegin, yEnd) in parallel. Each task is a block of m_BLOCK_ROWS rows over a run of 8 planes,
+        // calling _func once per plane (z outermost), and _func walks its rows with x innermost
+        template <typename Func>
+        void ForEachBlock(Func _func);
+
+        static const int m_BLOCK_ROWS = 16;
+
+        int m_gridDimensions;
+        float m_timeStep;
+        float m_diffusion;
+        float m_viscosity;
+
+        // Density
+        std::vector<float> m_prevDensity;
+        std::vector<float> m_density;
+
+        // Velocity
+        std::vector<float> m_xVelPrev;
+        std::vector<float> m_yVelPrev;
+        std::vector<float> m_zVelPrev;
+        std::vector<float> m_xVel;
+        std::vector<float> m_yVel;
+        std::vector<float> m_zVel;
+
+        ThreadPool m_threads;
+
+        // View
+        SDL_Renderer* m_renderer;
+        SDL_Texture* m_texture = NULL;
+        std::vector<Uint32> m_pixels;
+        bool m_maxProjection = true;
+        int m_slice;
+};
+
+#endif // _FLUID_3D_H_
@@ -0,0 +1,32 @@
+/// \brief Lossless field compression for recordings (XOR delta, byte planes, run-length encoding)
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef FRAME_CODEC_H_
+#define FRAME_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FrameCodec
+{
+    public:
+        // Appends the encoding of _current to _out. _previous is the same field from the last encoded frame,
+        // or NULL for a keyframe. Unchanged cells XOR to zero, and splitting the words into byte planes
+        // groups those zeros (and the mostly constant exponent bytes) into long runs for the RLE.
+        static void Encode(const uint32_t* _current, const uint32_t* _previous, size_t _count, std::vector<uint8_t>& _scratch, std::vector<uint8_t>& _out);
+
+        // Reverses Encode into _current, returns false if _size bytes don't decode to exactly _count words
+        static bool Decode(const uint8_t* _data, size_t _size, const uint32_t* _previous, size_t _count, std::vector<uint8_t>& _scratch, uint32_t* _current);
+
+    private:
+        static void RunLengthEncode(const uint8_t* _data, size_t _size, std::vector<uint8_t>& _out);
+        static bool RunLengthDecode(const uint8_t* _data, size_t _size, uint8_t* _out, size_t _outSize);
+};
+
+#endif // _FRAME_CODEC_H_
@@ -0,0 +1,93 @@
+/// \brief Maps 2D grid coordinates onto linear field storage (row-major or 8x8 tiles)
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Added tiled memory layout
+/// Revision History:
+///
+/// \todo
+
+#ifndef GRID_LAYOUT_H_
+#define GRID_LAYOUT_H_
+
+enum class MemoryLayout
+{
+    RowMajor,   // x + y * N
+    Tiled       // 8x8 tiles stored contiguously, tiles and cells within a tile both row-major
+};
+
+class GridLayout
+{
+    public:
+        static const int TILE_SHIFT = 3;
+        static const int TILE_SIZE = 1 << TILE_SHIFT;
+        static const int TILE_MASK = TILE_SIZE - 1;
+        static const int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+
+        GridLayout(MemoryLayout _layout = MemoryLayout::RowMajor, int _gridDimensions = 0);
+
+        // No bounds checking, callers must pass coordinates inside the grid
+        inline int GetIndex(int _xPos, int _yPos) const
+        {
+            if (m_layout == MemoryLayout::RowMajor)
+            {
+                return _xPos + (_yPos * m_gridDimensions);
+            }
+            return ((((_yPos >> TILE_SHIFT) * m_tilesPerRow) + (_xPos >> TILE_SHIFT)) << (2 * TILE_SHIFT)) |
+                   ((_yPos & TILE_MASK) << TILE_SHIFT) | (_xPos & TILE_MASK);
+        }
+
+        // Visits every cell in [_begin, _end) on both axes in storage order, calling _func(x, y, index).
+        // Stencil kernels should loop through this so tiled fields are streamed one tile at a time.
+        template <typename Func>
+        void ForEachCell(int _begin, int _end, Func&& _func) const
+        {
+            if (m_layout == MemoryLayout::RowMajor)
+            {
+                for (int j = _begin; j < _end; ++j)
+                {
+                    int index = GetIndex(_begin, j);
+                    for (int i = _begin; i < _end; ++i, ++index)
+                    {
+                        _func(i, j, index);
+                    }
+                }
+                return;
+            }
+
+            int firstTile = _begin >> TILE_SHIFT;
+            int lastTile = (_end - 1) >> TILE_SHIFT;
+            for (int ty = firstTile; ty <= lastTile; ++ty)
+            {
+                int yStart = ty * TILE_SIZE < _begin ? _begin : ty * TILE_SIZE;
+                int yEnd = (ty + 1) * TILE_SIZE > _end ? _end : (ty + 1) * TILE_SIZE;
+                for (int tx = firstTile; tx <= lastTile; ++tx)
+                {
+                    int xStart = tx * TILE_SIZE < _begin ? _begin : tx * TILE_SIZE;
+                    int xEnd = (tx + 1) * TILE_SIZE > _end ? _end : (tx + 1) * TILE_SIZE;
+                    for (int j = yStart; j < yEnd; ++j)
+                    {
+                        // Cells along a tile row are contiguous
+                        int index = GetIndex(xStart, j);
+                        for (int i = xStart; i < xEnd; ++i, ++index)
+                        {
+                            _func(i, j, index);
+                        }
+                    }
+                }
+            }
+        }
+
+        MemoryLayout GetLayout() const;
+        int GetGridDimensions() const;
+        int GetTilesPerRow() const;
+        int GetStorageSize() const;
+
+        static const char* GetName(MemoryLayout _layout);
+
+    private:
+        MemoryLayout m_layout;
+        int m_gridDimensions;
+        int m_tilesPerRow;
+};
+
+#endif // _GRID_LAYOUT_H_
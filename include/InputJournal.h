@@ -0,0 +1,118 @@
+/// \brief Records fluid inputs per frame to a binary log and feeds them back for reproducible runs
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef INPUT_JOURNAL_H_
+#define INPUT_JOURNAL_H_
+
+#include "Fluid.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// File layout: JournalHeader, the startup snapshot file's contents (startupSnapshotLength bytes, empty for a cold start),
+// then eventCount variable length events: uint32 frame, uint8 JournalEvent, payload
+//   Density    : int32 x, int32 y, float amount
+//   Velocity   : int32 x, int32 y, float amountX, float amountY
+//   Resolution : uint8 increase
+//   Reset      : (none)
+//   Obstacle   : int32 x, int32 y, int32 radius, uint8 solid
+//   ObstacleMask : uint32 length, image path (length bytes)
+//   Species    : int32 x, int32 y, uint8 species, float amount
+//   SpeciesCount : uint8 count
+//   Splats     : uint32 count, count Splat structs
+struct JournalHeader
+{
+    char magic[8];                  // "FLUIDJNL"
+    uint32_t byteOrder;             // 0x01020304 as written by the recording machine
+    uint32_t version;
+    int32_t screenDimensions;
+    uint32_t layout;                // MemoryLayout
+    float timeStep;
+    float diffusion;
+    float viscosity;
+    float fadeRate;
+    uint32_t frameCount;
+    uint32_t eventCount;
+    uint32_t startupSnapshotLength; // Embedded snapshot bytes (version 5, older journals stored its path)
+};
+
+enum class JournalEvent : uint8_t
+{
+    Density,
+    Velocity,
+    Resolution,
+    Reset,
+    Obstacle,
+    ObstacleMask,
+    Species,
+    SpeciesCount,
+    Splats
+};
+
+class InputJournal
+{
+    public:
+        static const uint32_t m_VERSION = 5;
+
+        InputJournal();
+        ~InputJournal();
+
+        // Recording, _header describes the fluid the events are applied to (counts are filled in by Stop).
+        // _startupSnapshot is the snapshot file the fluid started from, embedded so edits to the file can't change replays.
+        bool StartRecording(std::string _path, const JournalHeader& _header, const std::vector<uint8_t>& _startupSnapshot);
+        void Stop();
+        bool IsRecording();
+
+        // Apply the input to _fluid, logging it against _frame when recording
+        void AddDensity(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, float _amount);
+        void AddVelocity(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, float _amountX, float _amountY);
+        void ChangeResolution(Fluid& _fluid, uint32_t _frame, bool _scale);
+        void Reset(Fluid& _fluid, uint32_t _frame);
+        void PaintObstacle(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, int _radius, bool _solid);
+        // Only logged when the mask loads, replays need the same image at the same path
+        bool LoadObstacles(Fluid& _fluid, uint32_t _frame, std::string _path);
+        void SetSpeciesCount(Fluid& _fluid, uint32_t _frame, int _count);
+        void AddSplats(Fluid& _fluid, uint32_t _frame, const Splat* _splats, size_t _count);
+        // Marks _frame as stepped, so trailing frames without input are replayed too
+        void EndFrame(uint32_t _frame);
+
+        // Playback
+        bool Load(std::string _path);
+        bool IsLoaded();
+        // Applies every event logged for _frame, in the order they were recorded
+        void Replay(Fluid& _fluid, uint32_t _frame);
+        const JournalHeader& GetHeader();
+        // Snapshot file contents to start from, empty for a cold start
+        const std::vector<uint8_t>& GetStartupSnapshot();
+
+        static JournalHeader CreateHeader();
+
+    private:
+        template <typename T>
+        void Write(const T& _value);
+        void BeginEvent(uint32_t _frame, JournalEvent _event);
+
+        template <typename T>
+        bool Read(T& _value);
+
+        std::ofstream m_file;
+        bool m_recording = false;
+        JournalHeader m_header;
+        std::vector<uint8_t> m_startupSnapshot;
+
+        // Playback state, the whole journal is held in memory
+        std::vector<uint8_t> m_events;
+        size_t m_readOffset = 0;
+        uint32_t m_eventsRead = 0;
+        bool m_loaded = false;
+        std::vector<Splat> m_splats;
+};
+
+#endif // _INPUT_JOURNAL_H_
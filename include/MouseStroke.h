@@ -0,0 +1,52 @@
+/// \brief Collects every mouse motion event in a frame and turns the path into Fluid splats
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef MOUSE_STROKE_H_
+#define MOUSE_STROKE_H_
+
+#include "Fluid.h"
+
+#include <vector>
+
+class MouseStroke
+{
+    public:
+        MouseStroke();
+
+        // Starts a new path at (_xPos, _yPos), e.g. when a button is pressed
+        void Begin(int _xPos, int _yPos);
+        // Every SDL_MOUSEMOTION position, in order. Points that continue the current segment in a straight line
+        // (within m_TOLERANCE pixels) extend it instead of starting a new one
+        void AddPoint(int _xPos, int _yPos);
+
+        // Appends splats spaced half a radius apart along this frame's segments. The frame's input is shared out
+        // rather than repeated: each splat's velocity is its segment's displacement divided by the segment's splat
+        // count, and each gets _density divided by the frame's splat count. Overlapping splats therefore add up to
+        // one displacement (as SDLScene::CalculateVelocity) and one splat of density per frame, however fast the
+        // pointer moves. A pointer that hasn't moved gives a single splat with no velocity.
+        void BuildSplats(std::vector<Splat>& _splats, float _radius, float _density, bool _velocity, int _species);
+        // Drops the frame's segments, the last point starts the next frame's path
+        void EndFrame();
+
+        int GetSegmentCount();
+
+    private:
+        struct Point
+        {
+            float x;
+            float y;
+        };
+
+        static constexpr float m_TOLERANCE = 1.0f;
+
+        // Polyline for the current frame, the first point is where the previous frame ended
+        std::vector<Point> m_points;
+        bool m_started = false;
+};
+
+#endif // _MOUSE_STROKE_H_
@@ -0,0 +1,65 @@
+/// \brief Solid obstacles inside the fluid, compiled into boundary cell lists for SetBounds
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef OBSTACLES_H_
+#define OBSTACLES_H_
+
+#include <SDL2/SDL.h>
+
+#include "GridLayout.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Obstacles
+{
+    public:
+        Obstacles();
+
+        // Obstacles are kept as a screen space mask so they survive resolution changes.
+        // The mask is only allocated once something is painted or loaded.
+        bool LoadMask(std::string _path, int _screenDimensions);
+        void Paint(int _xPos, int _yPos, int _radius, bool _solid, int _screenDimensions);
+        bool IsDirty();
+
+        // Rasterises the mask onto the grid (a cell is solid if its centre pixel is) and builds the boundary lists
+        void Compile(const GridLayout& _layout, int _cellSize);
+
+        // Sets every solid cell from its fluid side neighbours, reflecting the velocity component normal to the wall.
+        // Branch free over the compiled lists, and free when there are no obstacles.
+        // Like the outer walls, a solid one cell thick still leaks through advection's bilinear lookups.
+        void Apply(int _b, std::vector<float>& _x);
+        // Same for an interleaved field, AdvectKernel::INTERLEAVED_WIDTH components per cell (_b = 0)
+        void ApplyInterleaved(std::vector<float>& _x);
+
+        void Draw(SDL_Renderer* _renderer, int _cellSize);
+
+    private:
+        template <int Width>
+        void ApplyTo(int _b, float* _x);
+
+        // Boundary cells whose fluid neighbour lies in one direction (+x, -x, +y, -y)
+        struct BoundaryList
+        {
+            std::vector<int> solid;
+            std::vector<int> fluid;
+            std::vector<float> weight;  // 1 / number of fluid neighbours of the solid cell
+        };
+
+        std::vector<uint8_t> m_mask;
+        int m_maskDimensions = 0;
+        bool m_dirty = false;
+
+        // Compiled
+        std::vector<int> m_solidCells;
+        std::vector<SDL_Point> m_solidPositions;
+        BoundaryList m_boundaries[4];
+};
+
+#endif // _OBSTACLES_H_
@@ -0,0 +1,73 @@
+/// \brief Passive tracer particles carried by the fluid velocity
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include <SDL2/SDL.h>
+
+#include "GridLayout.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+class Particles
+{
+    public:
+        // Storage for _capacity particles is allocated up front, _threads = 0 uses every hardware thread
+        Particles(int _capacity, int _threads = 0);
+
+        // Spawns _count particles scattered within _radius pixels of (_xPos, _yPos), on a grid of _gridDimensions
+        // cells of _cellSize pixels (existing particles are rescaled first if the resolution has changed).
+        // Slots come from the free list, particles are dropped once the pool is full.
+        void Emit(int _xPos, int _yPos, int _count, float _radius, int _gridDimensions, float _cellSize);
+
+        // Moves every live particle through (_xVel, _yVel) with a midpoint (RK2) step, on the same time scale as
+        // AdvectKernel. Runs in parallel chunks (8 at a time when built with AVX2), ages particles and rebuilds
+        // the point list in screen space (_cellSize pixels per cell).
+        void Update(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, float _cellSize);
+        // One batched point upload for every live particle
+        void Draw(SDL_Renderer* _renderer);
+        void Clear();
+
+        int GetCount();
+        int GetCapacity();
+
+    private:
+        // Keeps particles over the same screen position when the resolution changes
+        void Rescale(int _gridDimensions);
+        void Advance(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, int _begin, int _end);
+        void AdvanceParticle(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, int _index);
+
+        static const int m_CHUNK_SIZE = 16384;
+        static const int m_LIFETIME = 900;  // Frames
+
+        int m_capacity;
+        // Slots in [0, m_used) have been handed out at least once, dead ones are on m_freeList
+        int m_used = 0;
+        int m_alive = 0;
+        int m_gridDimensions = 0;
+        uint32_t m_seed = 1;
+
+        // Structure of arrays, positions are in grid cells
+        std::vector<float> m_x;
+        std::vector<float> m_y;
+        std::vector<int> m_life;        // Frames left, 0 = free slot
+        std::vector<int> m_freeList;
+
+        // Per chunk scratch, filled in parallel then packed
+        std::vector<SDL_FPoint> m_points;
+        std::vector<int> m_chunkPoints;
+        std::vector<std::vector<int>> m_chunkRetired;
+        int m_pointCount = 0;
+
+        ThreadPool m_threads;
+};
+
+#endif // _PARTICLES_H_
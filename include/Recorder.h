@@ -0,0 +1,110 @@
+/// \brief Captures fluid frames into a ring buffer and compresses them to disk on a background thread
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include "Fluid.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Container layout: RecordingHeader, then a stream of (RecordingFrameHeader, encoded field data) chunks.
+// Fields are stored in the grid's storage order, encoded with FrameCodec against the previous chunk's fields
+// unless the chunk is a keyframe.
+struct RecordingHeader
+{
+    char magic[8];              // "FLUIDREC"
+    uint32_t byteOrder;         // 0x01020304 as written by the recording machine
+    uint32_t version;
+};
+
+struct RecordingFrameHeader
+{
+    uint32_t frameNumber;       // Simulation frame, gaps mean dropped frames
+    uint32_t timeMs;            // Capture time since recording started
+    uint32_t gridDimensions;
+    uint32_t layout;            // MemoryLayout
+    uint32_t storageSize;       // Floats per field
+    uint32_t fieldCount;        // 1 (density) or 3 (density, x velocity, y velocity)
+    uint32_t keyframe;
+    uint32_t encodedSize[3];    // Bytes of encoded data per field, in order
+};
+
+class Recorder
+{
+    public:
+        static const uint32_t m_VERSION = 1;
+        static const uint32_t m_KEYFRAME_INTERVAL = 120;
+
+        Recorder();
+        ~Recorder();
+
+        // Every ring slot is allocated for _storageSize floats per field up front
+        bool Start(std::string _path, bool _includeVelocity, int _storageSize, int _ringFrames = 16);
+        void Stop();
+        bool IsRecording();
+        // Reallocates the ring when the grid's storage size changes, once the writer has drained it.
+        // Call after anything that can change the grid and before Capture(), which then only copies.
+        void Resize(int _storageSize);
+
+        // Called from the simulation thread once per frame. Copies the fields into a free ring slot,
+        // or counts a dropped frame if the writer has fallen behind. Never waits on the writer.
+        void Capture(Fluid& _fluid, uint32_t _frameNumber);
+
+        uint64_t GetCapturedFrames();
+        uint64_t GetDroppedFrames();
+        uint64_t GetWrittenBytes();
+
+    private:
+        struct Slot
+        {
+            RecordingFrameHeader header;
+            std::vector<float> fields[3];
+        };
+
+        void WriterThread();
+        void WriteFrame(Slot& _slot);
+        void AllocateSlots(int _storageSize);
+
+        std::vector<Slot> m_ring;
+        int m_slotSize = 0;
+        // Single producer (simulation) / single consumer (writer), m_head - m_tail frames are pending
+        std::atomic<uint64_t> m_head{0};
+        std::atomic<uint64_t> m_tail{0};
+        std::atomic<bool> m_running{false};
+
+        std::thread m_writer;
+        std::mutex m_wakeMutex;
+        std::condition_variable m_wake;
+
+        std::ofstream m_file;
+        bool m_includeVelocity = false;
+        std::chrono::steady_clock::time_point m_startTime;
+
+        // Writer thread state, previous frame for delta encoding
+        std::vector<uint32_t> m_previous[3];
+        RecordingFrameHeader m_previousHeader;
+        uint32_t m_framesSinceKeyframe = 0;
+        std::vector<uint8_t> m_scratch;
+        std::vector<uint8_t> m_encoded;
+
+        // Counters
+        std::atomic<uint64_t> m_capturedFrames{0};
+        std::atomic<uint64_t> m_droppedFrames{0};
+        std::atomic<uint64_t> m_writtenBytes{0};
+};
+
+#endif // _RECORDER_H_
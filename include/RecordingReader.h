@@ -0,0 +1,45 @@
+/// \brief Reads back recordings written by Recorder, one decoded frame at a time
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef RECORDING_READER_H_
+#define RECORDING_READER_H_
+
+#include "Recorder.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class RecordingReader
+{
+    public:
+        RecordingReader();
+
+        bool Open(std::string _path);
+        void Rewind();
+
+        // Decodes the next frame into GetField(0..fieldCount-1), false at the end of the recording or on corrupt data
+        bool ReadFrame();
+
+        const RecordingFrameHeader& GetFrameHeader();
+        const std::vector<float>& GetField(int _field);
+
+    private:
+        std::ifstream m_file;
+        std::string m_path;
+        std::streampos m_firstFrame;
+
+        RecordingFrameHeader m_header;
+        bool m_haveFrame = false;
+        std::vector<float> m_fields[3];
+        std::vector<uint8_t> m_encoded;
+        std::vector<uint8_t> m_scratch;
+};
+
+#endif // _RECORDING_READER_H_
@@ -0,0 +1,61 @@
+/// \brief Frozen scalar copy of the original Stam solver, the yardstick for the optimised kernels in Fluid
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef REFERENCE_SOLVER_H_
+#define REFERENCE_SOLVER_H_
+
+#include <vector>
+
+// Row-major, single threaded, no obstacles or species, exactly as the solver was first ported.
+// Leave it alone: Validation measures every fast path in Fluid against this, so changes to the
+// physics belong in Fluid (and show up as validation errors) rather than here.
+class ReferenceSolver
+{
+    public:
+        ReferenceSolver(int _gridDimensions, float _timeStep, float _diffusion, float _viscosity);
+
+        // The following functions have been implemented and ported from:
+        // Stam, Jos., 2003. Real-Time Fluid Dynamics for Games. [online]
+        // Available from: http://graphics.cs.cmu.edu/nsp/course/15-464/Fall09/papers/StamFluidforGames.pdf
+        // Accessed [18 March 2021]
+        void Diffuse(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timestep, int _iterations, int _gridDimensions);
+        void LinearSolve(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _a, float _c, int _iterations, int _gridDimensions);
+        void Project(std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _p, std::vector<float>& _div, int _iterations, int _gridDimensions);
+        void Advect(int _b, std::vector<float>& _d, std::vector<float>& _d0,  std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions);
+        void SetBounds(int _b, std::vector<float>& _x, int _gridDimensions);
+        // [End of reference]
+
+        void Fade(float _fadeRate);
+        void Update();
+
+        // Row-major fields, velocity is zeroed when not given
+        void SetState(const std::vector<float>& _density, const std::vector<float>* _xVel, const std::vector<float>* _yVel);
+
+        int GetGridIndex(int _xPos, int _yPos);
+        const std::vector<float>& GetDensity();
+        const std::vector<float>& GetXVelocity();
+        const std::vector<float>& GetYVelocity();
+
+    private:
+        int m_gridDimensions;
+        float m_timeStep;
+        float m_diffusion;
+        float m_viscosity;
+
+        // Density
+        std::vector<float> m_prevDensity;
+        std::vector<float> m_density;
+
+        // Velocity
+        std::vector<float> m_xVelPrev;
+        std::vector<float> m_yVelPrev;
+        std::vector<float> m_xVel;
+        std::vector<float> m_yVel;
+};
+
+#endif // _REFERENCE_SOLVER_H_
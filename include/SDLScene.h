@@ -11,7 +11,15 @@
 
 #include <SDL2/SDL.h>
 
+#include "GridLayout.h"
+#include "InputJournal.h"
 #include "KeyboardManager.h"
+#include "MouseStroke.h"
+#include "Recorder.h"
+#include "Telemetry.h"
+
+#include <string>
+#include <vector>
 
 class SDLScene
 {
@@ -20,11 +28,24 @@ class SDLScene
 
         bool Initialise();
         void GameLoop();
+        void PlayRecording(std::string _path);
+        bool ReplayInputHeadless();
+        void VolumeLoop(int _gridDimensions);
         void Close();
 
         void UpdateMousePosition();
         void CalculateVelocity();
 
+        void SetMemoryLayout(MemoryLayout _layout);
+        void SetStartupSnapshot(std::string _path);
+        void SetCaptureVelocity(bool _captureVelocity);
+        void SetInputRecording(std::string _path);
+        bool SetInputReplay(std::string _path);
+        void SetObstacles(std::string _path);
+        void SetParticleCapacity(int _capacity);
+        void SetSpeciesCount(int _count);
+        void SetTelemetry(std::string _path, float _rate);
+
     private:
         SDL_Window* m_window = NULL;
         SDL_Renderer* m_renderer = NULL;
@@ -33,6 +54,53 @@ class SDLScene
 
         const int m_SCREEN_SIZE = 512;
 
+        // Fluid parameters
+        const float m_TIME_STEP = 0.1f;
+        const float m_DIFFUSION = 0.0f;
+        const float m_VISCOSITY = 0.0f;
+        const float m_FADE_RATE = 0.01f;
+
+        // Fluid field storage order
+        MemoryLayout m_layout = MemoryLayout::RowMajor;
+
+        // Snapshots (F5 / F9 save and load m_snapshotPath)
+        std::string m_snapshotPath = "fluid.snap";
+        std::string m_startupSnapshot;
+
+        // Frame capture (C toggles recording to m_capturePath)
+        Recorder m_recorder;
+        std::string m_capturePath = "capture.flrec";
+        bool m_captureVelocity = false;
+        uint32_t m_frame = 0;
+
+        // Input journal, recorded to m_journalPath or replayed in place of live input
+        InputJournal m_journal;
+        std::string m_journalPath;
+
+        // Obstacles (O toggles painting them with the mouse)
+        std::string m_obstaclePath;
+        bool m_paintObstacles = false;
+        const int m_OBSTACLE_RADIUS = 12;
+
+        // Tracer particles (P toggles), emitted wherever density is added
+        int m_particleCapacity = 1 << 20;
+        bool m_showParticles = false;
+        const int m_PARTICLE_RATE = 2000;   // Per frame
+
+        // Dye species, number keys pick the one added with the mouse
+        int m_speciesCount = 0;
+        int m_activeSpecies = 0;
+
+        // Mouse motion since the last frame, applied as one batch of splats
+        MouseStroke m_stroke;
+        std::vector<Splat> m_splats;
+        const float m_SPLAT_RADIUS = 1.5f;  // Cells
+
+        // Solver statistics streamed to m_telemetryPath while a client is connected
+        Telemetry m_telemetry;
+        std::string m_telemetryPath;
+        float m_telemetryRate = Telemetry::m_DEFAULT_RATE;
+
         // Mouse position
         int m_prevMouseX;
         int m_prevMouseY;
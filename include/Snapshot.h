@@ -0,0 +1,97 @@
+/// \brief Versioned binary snapshot of the solver state, memory-mapped for loading
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// File layout:
+//   SnapshotHeader, padded out to m_BLOCK_ALIGNMENT bytes
+//   One raw float block per field, in the grid's storage order (see GridLayout),
+//   each starting on an m_BLOCK_ALIGNMENT boundary so it can be used straight from the mapping.
+//   Blocks hold storageSize floats, except the species which hold speciesWidth floats per cell (interleaved).
+// Version 1 headers end before speciesCount, those fields read as 0 from the header padding.
+struct SnapshotHeader
+{
+    char magic[8];              // "FLUIDSNP"
+    uint32_t byteOrder;         // 0x01020304 as written by the saving machine
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(SnapshotHeader)
+    uint32_t gridDimensions;
+    uint32_t layout;            // MemoryLayout
+    uint32_t storageSize;       // Floats per field block
+    int32_t cellSize;
+    int32_t scaleFactor;
+    float timeStep;
+    float diffusion;
+    float viscosity;
+    uint32_t fieldCount;
+    uint64_t fieldOffsets[8];   // Byte offset of each field block from the start of the file
+    uint32_t speciesCount;      // Dye species in use (version 2)
+    uint32_t speciesWidth;      // Floats per cell in the species blocks, 0 without them (version 2)
+};
+
+enum class SnapshotField
+{
+    Density,
+    XVelocity,
+    YVelocity,
+    PrevDensity,
+    PrevXVelocity,
+    PrevYVelocity,
+    Species,
+    PrevSpecies
+};
+
+class Snapshot
+{
+    public:
+        static const uint32_t m_VERSION = 2;
+        static const uint32_t m_MAX_FIELDS = 8;
+        static const size_t m_BLOCK_ALIGNMENT = 4096;
+
+        Snapshot();
+        ~Snapshot();
+
+        static bool Save(std::string _path, const SnapshotHeader& _header, const float* const* _fields);
+
+        bool Open(std::string _path);
+        // Uses a whole snapshot file already in memory, _data must outlive the Snapshot. _name is only used in messages.
+        bool Open(const unsigned char* _data, size_t _size, std::string _name);
+        void Close();
+        // Reads a whole snapshot file (unchecked, Open the bytes to validate them)
+        static bool ReadFile(std::string _path, std::vector<uint8_t>& _bytes);
+
+        const SnapshotHeader* GetHeader();
+        // Bytes in the mapped file
+        size_t GetSize();
+        // Points directly into the mapped file, valid until Close()
+        const float* GetField(SnapshotField _field);
+
+        static SnapshotHeader CreateHeader();
+        // Floats in field block _field
+        static uint64_t GetFieldSize(const SnapshotHeader& _header, uint32_t _field);
+
+    private:
+        bool Validate(std::string _path);
+
+        const unsigned char* m_data = NULL;
+        size_t m_size = 0;
+        // m_data belongs to the caller, nothing to unmap or free
+        bool m_borrowed = false;
+#ifdef _WIN32
+        // No mmap, the file is read into memory instead
+        unsigned char* m_buffer = NULL;
+#endif
+};
+
+#endif // _SNAPSHOT_H_
@@ -0,0 +1,56 @@
+/// \brief Streams solver statistics as newline-delimited JSON to clients of a Unix domain socket
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "Fluid.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One JSON object per line, e.g.
+// {"frame":120,"frame_ms":16.7,"grid":128,"iterations":4,"stages_ms":{...},"pressure_residual":0.01,
+//  "total_density":5120.0,"max_velocity":3.2,"divergence":0.002}
+// Nothing is gathered or formatted while no client is connected.
+class Telemetry
+{
+    public:
+        static constexpr float m_DEFAULT_RATE = 10.0f;
+
+        Telemetry();
+        ~Telemetry();
+
+        // Listens on _path (replacing a stale socket file) and publishes at most _rate lines per second
+        bool Start(std::string _path, float _rate = m_DEFAULT_RATE);
+        void Stop();
+        bool IsRunning();
+
+        // Called once per frame before Fluid::Update. Accepts waiting clients once per publish interval and
+        // returns true when a line should be published this frame (enable Fluid stats for the Update)
+        bool IsDue();
+        // Sends one line to every client. Slow clients miss lines rather than stalling the simulation
+        void Publish(uint32_t _frame, double _frameMs, const FluidStats& _stats);
+
+        int GetClientCount();
+
+    private:
+        void AcceptClients();
+
+        std::string m_path;
+        int m_socket = -1;
+        std::vector<int> m_clients;
+
+        std::chrono::steady_clock::duration m_interval;
+        std::chrono::steady_clock::time_point m_nextPublish;
+        std::string m_line;
+};
+
+#endif // _TELEMETRY_H_
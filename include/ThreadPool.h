@@ -0,0 +1,52 @@
+/// \brief Persistent worker threads for splitting solver loops across cores
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+    public:
+        // _threads = 0 uses every hardware thread
+        ThreadPool(int _threads = 0);
+        ~ThreadPool();
+
+        // Splits [_begin, _end) into chunks and runs _func(chunkBegin, chunkEnd) on the workers and the calling thread.
+        // Returns once every chunk has finished. Chunks are claimed dynamically, so _func must not depend on which thread runs it.
+        void ParallelFor(int _begin, int _end, const std::function<void(int, int)>& _func);
+
+        int GetThreadCount();
+
+    private:
+        void Worker();
+        void RunChunks();
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_start;
+        std::condition_variable m_done;
+
+        // Current job
+        const std::function<void(int, int)>* m_job = NULL;
+        int m_end = 0;
+        int m_chunkSize = 1;
+        std::atomic<int> m_next{0};
+        uint64_t m_generation = 0;
+        int m_busyWorkers = 0;
+        bool m_quit = false;
+};
+
+#endif // _THREAD_POOL_H_
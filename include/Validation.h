@@ -0,0 +1,76 @@
+/// \brief Headless check of the optimised solver kernels against the frozen ReferenceSolver
+/// \author Josh Bailey
+/// \version 1.0
+/// \date 19/10/26 Initial version
+/// Revision History:
+///
+/// \todo
+
+#ifndef VALIDATION_H_
+#define VALIDATION_H_
+
+#include "GridLayout.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every check runs a Fluid kernel (both memory layouts, AVX2 when built with it) and the reference on the
+// same randomised or scripted fields, then prints max / L2 error relative to the reference, speedup, and
+// divergence or mass drift where they apply. Tolerances are per kernel: exact where the kernel only copies
+// values, small relative errors where FMA contraction or the vector backtrace round differently.
+class Validation
+{
+    public:
+        Validation(uint32_t _seed);
+
+        // False when any check is over its tolerance
+        bool Run();
+
+    private:
+        // Relative to the reference field's largest magnitude and L2 norm
+        struct Error
+        {
+            double max;
+            double l2;
+        };
+
+        void CheckSetBounds(MemoryLayout _layout, int _gridDimensions);
+        void CheckLinearSolve(MemoryLayout _layout, int _gridDimensions);
+        void CheckProject(MemoryLayout _layout, int _gridDimensions);
+        void CheckAdvect(MemoryLayout _layout, int _gridDimensions);
+        void CheckFade(MemoryLayout _layout, int _gridDimensions);
+        void CheckSpecies(MemoryLayout _layout, int _gridDimensions);
+        void CheckStep(MemoryLayout _layout, int _gridDimensions);
+        void CheckObstacles(MemoryLayout _layout, int _gridDimensions);
+        void CheckVolume(int _gridDimensions);
+
+        // Prints one row, a check fails when _error.max is over _tolerance or _passed is false
+        void Report(const char* _kernel, const char* _backend, int _gridDimensions, const char* _case, Error _error,
+                    double _tolerance, double _referenceMs, double _ms, const std::string& _note = "", bool _passed = true);
+
+        // Allowed relative error for advection on a random field
+        static double AdvectTolerance(int _gridDimensions);
+        // Row-major field of uniform values in [_min, _max]
+        std::vector<float> RandomField(int _gridDimensions, float _min, float _max);
+
+        static std::vector<float> ToLayout(const GridLayout& _grid, const std::vector<float>& _field);
+        static Error Compare(const GridLayout& _grid, const std::vector<float>& _field, const std::vector<float>& _reference);
+        // RMS of the central difference divergence over interior cells, in cell units
+        static double Divergence(const GridLayout& _grid, const std::vector<float>& _xVel, const std::vector<float>& _yVel);
+        static double Total(const GridLayout& _grid, const std::vector<float>& _field);
+
+        uint32_t m_seed;
+        int m_checks = 0;
+        int m_failures = 0;
+
+        // 37 exercises the scalar remainder of the 8-wide kernels and partial tiles
+        std::vector<int> m_gridSizes = {16, 37, 64, 256};
+        static const int m_ITERATIONS = 4;         // As Fluid::Update
+        static const int m_STEP_FRAMES = 10;
+        static const int m_REPEATS = 3;            // Timings are the best of these
+        static constexpr float m_TIME_STEP = 0.1f;
+        static constexpr float m_DIFFUSION = 0.0001f;
+};
+
+#endif // _VALIDATION_H_
@@ -0,0 +1,231 @@
+///
+/// @file AdvectKernel.cpp
+/// @brief Semi-Lagrangian advection kernel (AVX2 8-wide with a scalar fallback)
+
+#include "AdvectKernel.h"
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Backtraces interior cell (_i, _j) and calls _blend(index, index00, index01, index10, index11, s0, s1, t0, t1)
+    // with the cell's storage index, its four bilinear taps and their weights
+    template <typename Blend>
+    void TraceCell(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, int _i, int _j, Blend _blend)
+    {
+        int gridDimensions = _layout.GetGridDimensions();
+        int index = _layout.GetIndex(_i, _j);
+
+        // Linear backtracing
+        float x = std::min(std::max(_i - (_timeStep * _xVel[index]), 0.5f), gridDimensions + 0.5f);
+        float y = std::min(std::max(_j - (_timeStep * _yVel[index]), 0.5f), gridDimensions + 0.5f);
+
+        int i0 = int(x);
+        int j0 = int(y);
+        float s1 = x - i0;
+        float s0 = 1.0f - s1;
+        float t1 = y - j0;
+        float t0 = 1.0f - t1;
+
+        // Constrain neighbours to the grid
+        int i1 = std::min(i0 + 1, gridDimensions - 1);
+        int j1 = std::min(j0 + 1, gridDimensions - 1);
+        i0 = std::min(i0, gridDimensions - 1);
+        j0 = std::min(j0, gridDimensions - 1);
+
+        _blend(index, _layout.GetIndex(i0, j0), _layout.GetIndex(i0, j1), _layout.GetIndex(i1, j0), _layout.GetIndex(i1, j1), s0, s1, t0, t1);
+    }
+
+    // Backtraces every interior cell. With AVX2, rows are walked in chunks of 8 cells and _chunk receives the same
+    // arguments as _cell as 8-lane vectors (index is the first cell, the 8 are contiguous in either layout).
+    // _timeStep is already scaled to grid cells.
+    template <typename Chunk, typename Cell>
+    void Trace(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, Chunk _chunk, Cell _cell)
+    {
+        int gridDimensions = _layout.GetGridDimensions();
+
+#ifdef __AVX2__
+        const __m256 dt = _mm256_set1_ps(_timeStep);
+        const __m256 lower = _mm256_set1_ps(0.5f);
+        const __m256 upper = _mm256_set1_ps(gridDimensions + 0.5f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256i maxIndex = _mm256_set1_epi32(gridDimensions - 1);
+        const __m256i oneInt = _mm256_set1_epi32(1);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i rowStride = _mm256_set1_epi32(gridDimensions);
+        const __m256i tilesPerRow = _mm256_set1_epi32(_layout.GetTilesPerRow());
+        const __m256i tileMask = _mm256_set1_epi32(GridLayout::TILE_MASK);
+        const bool tiled = _layout.GetLayout() == MemoryLayout::Tiled;
+
+        // Storage index of (x, y) for all 8 lanes, matching GridLayout::GetIndex
+        auto indexOf = [&](__m256i _x, __m256i _y)
+        {
+            if (!tiled)
+            {
+                return _mm256_add_epi32(_x, _mm256_mullo_epi32(_y, rowStride));
+            }
+            __m256i tile = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(_y, GridLayout::TILE_SHIFT), tilesPerRow),
+                                            _mm256_srli_epi32(_x, GridLayout::TILE_SHIFT));
+            __m256i local = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_y, tileMask), GridLayout::TILE_SHIFT),
+                                            _mm256_and_si256(_x, tileMask));
+            return _mm256_or_si256(_mm256_slli_epi32(tile, 2 * GridLayout::TILE_SHIFT), local);
+        };
+
+        // Chunks start on multiples of 8, so each one is 8 contiguous floats in either layout
+        int vectorEnd = gridDimensions & ~7;
+
+        for (int j = 1; j < gridDimensions - 1; ++j)
+        {
+            const __m256 y = _mm256_set1_ps(float(j));
+
+            // The first and last chunks also cover the boundary columns, which SetBounds overwrites afterwards
+            for (int i = 0; i < vectorEnd; i += 8)
+            {
+                int index = _layout.GetIndex(i, j);
+                __m256i xInt = _mm256_add_epi32(_mm256_set1_epi32(i), lanes);
+
+                // Backtrace and clamp (branchless)
+                __m256 xBack = _mm256_fnmadd_ps(dt, _mm256_loadu_ps(_xVel + index), _mm256_cvtepi32_ps(xInt));
+                __m256 yBack = _mm256_fnmadd_ps(dt, _mm256_loadu_ps(_yVel + index), y);
+                xBack = _mm256_min_ps(_mm256_max_ps(xBack, lower), upper);
+                yBack = _mm256_min_ps(_mm256_max_ps(yBack, lower), upper);
+
+                // Integer cell and fractional weights
+                __m256 xFloor = _mm256_floor_ps(xBack);
+                __m256 yFloor = _mm256_floor_ps(yBack);
+                __m256 s1 = _mm256_sub_ps(xBack, xFloor);
+                __m256 t1 = _mm256_sub_ps(yBack, yFloor);
+                __m256 s0 = _mm256_sub_ps(one, s1);
+                __m256 t0 = _mm256_sub_ps(one, t1);
+
+                // Neighbouring cells, constrained to the grid like Fluid::GetGridIndex
+                __m256i i0 = _mm256_cvttps_epi32(xFloor);
+                __m256i j0 = _mm256_cvttps_epi32(yFloor);
+                __m256i i1 = _mm256_min_epi32(_mm256_add_epi32(i0, oneInt), maxIndex);
+                __m256i j1 = _mm256_min_epi32(_mm256_add_epi32(j0, oneInt), maxIndex);
+                i0 = _mm256_min_epi32(i0, maxIndex);
+                j0 = _mm256_min_epi32(j0, maxIndex);
+
+                _chunk(index, indexOf(i0, j0), indexOf(i0, j1), indexOf(i1, j0), indexOf(i1, j1), s0, s1, t0, t1);
+            }
+
+            // Remaining interior cells when the grid isn't a multiple of 8 wide
+            for (int i = std::max(vectorEnd, 1); i < gridDimensions - 1; ++i)
+            {
+                TraceCell(_layout, _xVel, _yVel, _timeStep, i, j, _cell);
+            }
+        }
+#else
+        (void)_chunk;
+        _layout.ForEachCell(1, gridDimensions - 1, [&](int i, int j, int)
+        {
+            TraceCell(_layout, _xVel, _yVel, _timeStep, i, j, _cell);
+        });
+#endif
+    }
+}
+
+void AdvectKernel::Advect(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep,
+                          float* const* _d, const float* const* _d0, int _count)
+{
+    float timeStep = _timeStep * (_layout.GetGridDimensions() - 2);
+
+    auto cell = [&](int _index, int _index00, int _index01, int _index10, int _index11, float _s0, float _s1, float _t0, float _t1)
+    {
+        for (int n = 0; n < _count; ++n)
+        {
+            const float* source = _d0[n];
+            _d[n][_index] = _s0 * (_t0 * source[_index00] + _t1 * source[_index01]) +
+                            _s1 * (_t0 * source[_index10] + _t1 * source[_index11]);
+        }
+    };
+
+#ifdef __AVX2__
+    auto chunk = [&](int _index, __m256i _index00, __m256i _index01, __m256i _index10, __m256i _index11, __m256 _s0, __m256 _s1, __m256 _t0, __m256 _t1)
+    {
+        // Bilinear blend of the four taps, per field
+        for (int n = 0; n < _count; ++n)
+        {
+            const float* source = _d0[n];
+            __m256 d00 = _mm256_i32gather_ps(source, _index00, 4);
+            __m256 d01 = _mm256_i32gather_ps(source, _index01, 4);
+            __m256 d10 = _mm256_i32gather_ps(source, _index10, 4);
+            __m256 d11 = _mm256_i32gather_ps(source, _index11, 4);
+
+            __m256 left = _mm256_fmadd_ps(_t1, d01, _mm256_mul_ps(_t0, d00));
+            __m256 right = _mm256_fmadd_ps(_t1, d11, _mm256_mul_ps(_t0, d10));
+            _mm256_storeu_ps(_d[n] + _index, _mm256_fmadd_ps(_s1, right, _mm256_mul_ps(_s0, left)));
+        }
+    };
+#else
+    int chunk = 0;
+#endif
+
+    Trace(_layout, _xVel, _yVel, timeStep, chunk, cell);
+}
+
+void AdvectKernel::AdvectInterleaved(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep,
+                                     float* _d, const float* _d0)
+{
+    const int width = INTERLEAVED_WIDTH;
+    float timeStep = _timeStep * (_layout.GetGridDimensions() - 2);
+
+    // Every tap is one contiguous group of components
+    auto cell = [&](int _index, int _index00, int _index01, int _index10, int _index11, float _s0, float _s1, float _t0, float _t1)
+    {
+        const float* d00 = _d0 + _index00 * width;
+        const float* d01 = _d0 + _index01 * width;
+        const float* d10 = _d0 + _index10 * width;
+        const float* d11 = _d0 + _index11 * width;
+        float* d = _d + _index * width;
+        for (int n = 0; n < width; ++n)
+        {
+            d[n] = _s0 * (_t0 * d00[n] + _t1 * d01[n]) + _s1 * (_t0 * d10[n] + _t1 * d11[n]);
+        }
+    };
+
+#ifdef __AVX2__
+    // Backtraces 8 cells at once, then blends each cell's 4 components with one 128-bit load per tap
+    static_assert(INTERLEAVED_WIDTH == 4, "tap offsets below assume 4 components per cell");
+    auto chunk = [&](int _index, __m256i _index00, __m256i _index01, __m256i _index10, __m256i _index11, __m256 _s0, __m256 _s1, __m256 _t0, __m256 _t1)
+    {
+        alignas(32) int taps[4][8];
+        alignas(32) float weights[4][8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(taps[0]), _mm256_slli_epi32(_index00, 2));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(taps[1]), _mm256_slli_epi32(_index01, 2));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(taps[2]), _mm256_slli_epi32(_index10, 2));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(taps[3]), _mm256_slli_epi32(_index11, 2));
+        _mm256_store_ps(weights[0], _s0);
+        _mm256_store_ps(weights[1], _s1);
+        _mm256_store_ps(weights[2], _t0);
+        _mm256_store_ps(weights[3], _t1);
+
+        float* d = _d + _index * width;
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            __m128 t0 = _mm_set1_ps(weights[2][lane]);
+            __m128 t1 = _mm_set1_ps(weights[3][lane]);
+            __m128 left = _mm_fmadd_ps(t1, _mm_loadu_ps(_d0 + taps[1][lane]), _mm_mul_ps(t0, _mm_loadu_ps(_d0 + taps[0][lane])));
+            __m128 right = _mm_fmadd_ps(t1, _mm_loadu_ps(_d0 + taps[3][lane]), _mm_mul_ps(t0, _mm_loadu_ps(_d0 + taps[2][lane])));
+            _mm_storeu_ps(d + lane * width, _mm_fmadd_ps(_mm_set1_ps(weights[1][lane]), right, _mm_mul_ps(_mm_set1_ps(weights[0][lane]), left)));
+        }
+    };
+#else
+    int chunk = 0;
+#endif
+
+    Trace(_layout, _xVel, _yVel, timeStep, chunk, cell);
+}
+
+bool AdvectKernel::IsVectorised()
+{
+#ifdef __AVX2__
+    return true;
+#else
+    return false;
+#endif
+}
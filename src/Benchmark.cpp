@@ -0,0 +1,207 @@
+///
+/// @file Benchmark.cpp
+/// @brief Headless solver benchmark, compares memory layouts by throughput and cache misses
+
+#include "Benchmark.h"
+#include "Fluid.h"
+#include "Fluid3D.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Hardware cache miss counter for the calling thread (Linux perf events only).
+    // Reports unavailable when perf is not supported or blocked by perf_event_paranoid.
+    class CacheMissCounter
+    {
+        public:
+            CacheMissCounter(uint32_t _type, uint64_t _config)
+            {
+#ifdef __linux__
+                perf_event_attr attr = {};
+                attr.type = _type;
+                attr.size = sizeof(attr);
+                attr.config = _config;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                m_fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+            }
+
+            ~CacheMissCounter()
+            {
+#ifdef __linux__
+                if (m_fd >= 0)
+                {
+                    close(m_fd);
+                }
+#endif
+            }
+
+            bool IsAvailable()
+            {
+                return m_fd >= 0;
+            }
+
+            void Start()
+            {
+#ifdef __linux__
+                if (m_fd >= 0)
+                {
+                    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+            }
+
+            uint64_t Stop()
+            {
+                uint64_t count = 0;
+#ifdef __linux__
+                if (m_fd >= 0)
+                {
+                    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+                    if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+                    {
+                        count = 0;
+                    }
+                }
+#endif
+                return count;
+            }
+
+        private:
+            int m_fd = -1;
+    };
+}
+
+Benchmark::Benchmark(int _frames)
+{
+    m_frames = _frames;
+}
+
+void Benchmark::Run()
+{
+    std::printf("%-10s %6s %12s %12s %16s %16s %14s\n", "layout", "N", "ms/frame", "Mcells/s", "LLC miss/frame", "L1D miss/frame", "density sum");
+    for (int gridDimensions : m_gridSizes)
+    {
+        RunCase(MemoryLayout::RowMajor, gridDimensions);
+        RunCase(MemoryLayout::Tiled, gridDimensions);
+    }
+}
+
+void Benchmark::RunCase(MemoryLayout _layout, int _gridDimensions)
+{
+    // Fluid derives its grid from screen size / cell size (32 pixels at the default resolution)
+    const int cellSize = 32;
+    int screenDimensions = _gridDimensions * cellSize;
+    Fluid fluid(screenDimensions, 0.1f, 0, 0, NULL, _layout);
+
+#ifdef __linux__
+    CacheMissCounter llcMisses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    CacheMissCounter l1dMisses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+    CacheMissCounter llcMisses(0, 0);
+    CacheMissCounter l1dMisses(0, 0);
+#endif
+
+    uint64_t llcTotal = 0;
+    uint64_t l1dTotal = 0;
+    double seconds = 0;
+
+    for (int frame = 0; frame < m_frames; ++frame)
+    {
+        // Same scripted workload for every layout: a rotating jet injecting density from the centre
+        float angle = frame * 0.1f;
+        int centre = screenDimensions / 2;
+        fluid.AddDensity(centre, centre, 255);
+        fluid.AddVelocity(centre, centre, std::cos(angle) * 50.0f, std::sin(angle) * 50.0f);
+
+        llcMisses.Start();
+        l1dMisses.Start();
+        auto start = std::chrono::steady_clock::now();
+
+        fluid.Update();
+        fluid.Fade(0.01f);
+
+        auto end = std::chrono::steady_clock::now();
+        l1dTotal += l1dMisses.Stop();
+        llcTotal += llcMisses.Stop();
+        seconds += std::chrono::duration<double>(end - start).count();
+    }
+
+    double density = 0;
+    for (float d : fluid.GetDensity())
+    {
+        density += d;
+    }
+
+    double msPerFrame = seconds * 1000.0 / m_frames;
+    double cellsPerSecond = double(_gridDimensions) * _gridDimensions * m_frames / seconds;
+
+    char llc[32] = "n/a";
+    char l1d[32] = "n/a";
+    if (llcMisses.IsAvailable())
+    {
+        std::snprintf(llc, sizeof(llc), "%.0f", double(llcTotal) / m_frames);
+    }
+    if (l1dMisses.IsAvailable())
+    {
+        std::snprintf(l1d, sizeof(l1d), "%.0f", double(l1dTotal) / m_frames);
+    }
+
+    std::printf("%-10s %6d %12.3f %12.2f %16s %16s %14.2f\n", GridLayout::GetName(_layout), _gridDimensions, msPerFrame, cellsPerSecond / 1.0e6, llc, l1d, density);
+    std::fflush(stdout);
+    fluid.Destroy();
+}
+
+void Benchmark::RunVolume()
+{
+    std::printf("%6s %8s %12s %12s %14s\n", "N", "threads", "ms/frame", "Mcells/s", "density sum");
+    for (int gridDimensions : m_volumeSizes)
+    {
+        RunVolumeCase(gridDimensions);
+    }
+}
+
+void Benchmark::RunVolumeCase(int _gridDimensions)
+{
+    Fluid3D fluid(_gridDimensions, 0.1f, 0, 0, NULL);
+    double seconds = 0;
+
+    for (int frame = 0; frame < m_frames; ++frame)
+    {
+        // Rotating jet in the middle of the volume
+        float angle = frame * 0.1f;
+        int centre = _gridDimensions / 2;
+        fluid.AddDensity(centre, centre, centre, 255);
+        fluid.AddVelocity(centre, centre, centre, std::cos(angle) * 50.0f, std::sin(angle) * 50.0f, 10.0f);
+
+        auto start = std::chrono::steady_clock::now();
+        fluid.Update();
+        fluid.Fade(0.01f);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double density = 0;
+    for (float d : fluid.GetDensity())
+    {
+        density += d;
+    }
+
+    double cells = double(_gridDimensions) * _gridDimensions * _gridDimensions;
+    std::printf("%6d %8d %12.3f %12.2f %14.2f\n", _gridDimensions, fluid.GetThreadCount(), seconds * 1000.0 / m_frames, cells * m_frames / seconds / 1.0e6, density);
+    std::fflush(stdout);
+    fluid.Destroy();
+}
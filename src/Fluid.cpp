@@ -3,13 +3,20 @@
 /// @brief Updates all fluid parameters
 
 #include "Fluid.h"
+#include "AdvectKernel.h"
+#include "Snapshot.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-Fluid::Fluid(int _screenDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer)
+static_assert(Fluid::m_MAX_SPECIES == AdvectKernel::INTERLEAVED_WIDTH, "species are advected as one interleaved field");
+
+Fluid::Fluid(int _screenDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer, MemoryLayout _layout)
 {
     m_screenDimensions = _screenDimensions;
     m_gridDimensions = m_screenDimensions / m_cellSize;
+    m_layout = GridLayout(_layout, m_gridDimensions);
     m_timeStep = _timeStep;
     m_diffusion = _diffusion;
     m_viscosity = _viscosity;
@@ -17,31 +24,124 @@ Fluid::Fluid(int _screenDimensions, float _timeStep, float _diffusion, float _vi
 
     m_renderer = _renderer;
 
-    // Load arrow
-    m_arrow.Load("../../images/velArrow.png", m_renderer);
+    // Load arrow (headless runs have no renderer)
+    if (m_renderer != NULL)
+    {
+        m_arrow.Load("../../images/velArrow.png", m_renderer);
+    }
 }
 
 void Fluid::AddDensity(int _xPos, int _yPos, float _amount)
 {
-    _xPos /= m_cellSize;
-    _yPos /= m_cellSize;
-
-    m_density[GetGridIndex(_xPos, _yPos)] += _amount;
+    int index = GetGridIndex(_xPos / m_cellSize, _yPos / m_cellSize);
+    m_density[index] += _amount;
 
     // Constrain density to avoid overflow of RGBA values
-    if (m_density[GetGridIndex(_xPos, _yPos)] > 255.0f)
+    if (m_density[index] > 255.0f)
     {
-        m_density[GetGridIndex(_xPos, _yPos)] = 255.0f;
+        m_density[index] = 255.0f;
     }
 }
 
 void Fluid::AddVelocity(int _xPos, int _yPos, float _amountX, float _amountY)
 {
-    _xPos /= m_cellSize;
-    _yPos /= m_cellSize;
+    int index = GetGridIndex(_xPos / m_cellSize, _yPos / m_cellSize);
+    m_xVel[index] += _amountX;
+    m_yVel[index] += _amountY;
+}
+
+void Fluid::AddSplats(const Splat* _splats, size_t _count)
+{
+    const int tileSize = GridLayout::TILE_SIZE;
+    int tilesPerRow = (m_gridDimensions + tileSize - 1) / tileSize;
+    if (int(m_splatBins.size()) != tilesPerRow * tilesPerRow)
+    {
+        m_splatBins = std::vector<std::vector<int>>(tilesPerRow * tilesPerRow);
+    }
+
+    // Screen space to grid cells (cell centres at whole numbers), binned by every tile the footprint overlaps
+    m_splatSources.clear();
+    m_touchedTiles.clear();
+    for (size_t n = 0; n < _count; ++n)
+    {
+        const Splat& splat = _splats[n];
+        float radius = std::max(splat.radius / m_cellSize, 0.5f);
+        float sigma = radius / 3.0f;
+        SplatSource source = {splat.x / m_cellSize - 0.5f, splat.y / m_cellSize - 0.5f, radius * radius, 1.0f / (2.0f * sigma * sigma),
+                              splat.density, splat.xVel, splat.yVel, splat.species < m_speciesCount ? splat.species : -1};
+
+        // Interior cells only, SetBounds owns the walls
+        int xBegin = std::max(int(std::ceil(source.x - radius)), 1);
+        int xEnd = std::min(int(std::floor(source.x + radius)), m_gridDimensions - 2);
+        int yBegin = std::max(int(std::ceil(source.y - radius)), 1);
+        int yEnd = std::min(int(std::floor(source.y + radius)), m_gridDimensions - 2);
+        if (xBegin > xEnd || yBegin > yEnd)
+        {
+            continue;
+        }
+
+        int id = int(m_splatSources.size());
+        m_splatSources.push_back(source);
+        for (int ty = yBegin / tileSize; ty <= yEnd / tileSize; ++ty)
+        {
+            for (int tx = xBegin / tileSize; tx <= xEnd / tileSize; ++tx)
+            {
+                std::vector<int>& bin = m_splatBins[tx + ty * tilesPerRow];
+                if (bin.empty())
+                {
+                    m_touchedTiles.push_back(tx + ty * tilesPerRow);
+                }
+                bin.push_back(id);
+            }
+        }
+    }
+
+    // One visit per touched tile, each cell sums its bin and is written once
+    for (int tile : m_touchedTiles)
+    {
+        std::vector<int>& bin = m_splatBins[tile];
+        int xBegin = std::max((tile % tilesPerRow) * tileSize, 1);
+        int xEnd = std::min((tile % tilesPerRow + 1) * tileSize, m_gridDimensions - 1);
+        int yBegin = std::max((tile / tilesPerRow) * tileSize, 1);
+        int yEnd = std::min((tile / tilesPerRow + 1) * tileSize, m_gridDimensions - 1);
+
+        for (int j = yBegin; j < yEnd; ++j)
+        {
+            for (int i = xBegin; i < xEnd; ++i)
+            {
+                float density = 0.0f;
+                float xVel = 0.0f;
+                float yVel = 0.0f;
+                float species[m_MAX_SPECIES] = {};
+                for (int id : bin)
+                {
+                    const SplatSource& source = m_splatSources[id];
+                    float dx = i - source.x;
+                    float dy = j - source.y;
+                    float distanceSquared = dx * dx + dy * dy;
+                    float weight = distanceSquared <= source.radiusSquared ? std::exp(-distanceSquared * source.falloff) : 0.0f;
+                    density += weight * source.density;
+                    xVel += weight * source.xVel;
+                    yVel += weight * source.yVel;
+                    if (source.species >= 0)
+                    {
+                        species[source.species] += weight * source.density;
+                    }
+                }
 
-    m_xVel[GetGridIndex(_xPos, _yPos)] += _amountX;
-    m_yVel[GetGridIndex(_xPos, _yPos)] += _amountY;
+                int index = m_layout.GetIndex(i, j);
+                m_density[index] = std::min(m_density[index] + density, 255.0f);
+                m_xVel[index] += xVel;
+                m_yVel[index] += yVel;
+                for (int n = 0; n < m_speciesCount; ++n)
+                {
+                    float& value = m_species[index * m_MAX_SPECIES + n];
+                    value = std::min(value + species[n], 255.0f);
+                }
+            }
+        }
+        bin.clear();
+    }
 }
 
 void Fluid::Diffuse(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timestep, int _iterations, int _gridDimensions)
@@ -55,20 +155,17 @@ void Fluid::LinearSolve(int _b, std::vector<float>& _x, std::vector<float>& _xPr
     // More iterations = more accuracy
     for (int k = 0; k < _iterations; ++k)
     {
-        // Loop all cells (excluding boundaries)
-        for (int j = 1; j < _gridDimensions - 1; ++j)
+        // Loop all cells (excluding boundaries) in storage order
+        m_layout.ForEachCell(1, _gridDimensions - 1, [&](int i, int j, int index)
         {
-            for (int i = 1; i < _gridDimensions - 1; ++i)
-            {
-                // Each cells diffusion amount is a product of itself and its direct surrounding neighbours using Gauss-Seidel relaxtion
-                _x[GetGridIndex(i, j)] = (_xPrev[GetGridIndex(i, j)] + _a *
-                                             (_x[GetGridIndex(i + 1, j)] +      // Right
-                                              _x[GetGridIndex(i - 1, j)] +      // Left
-                                              _x[GetGridIndex(i, j + 1)] +      // Down
-                                              _x[GetGridIndex(i, j - 1 )]))     // Up
-                                              / _c;
-                }
-            }
+            // Each cells diffusion amount is a product of itself and its direct surrounding neighbours using Gauss-Seidel relaxtion
+            _x[index] = (_xPrev[index] + _a *
+                            (_x[m_layout.GetIndex(i + 1, j)] +      // Right
+                             _x[m_layout.GetIndex(i - 1, j)] +      // Left
+                             _x[m_layout.GetIndex(i, j + 1)] +      // Down
+                             _x[m_layout.GetIndex(i, j - 1)]))      // Up
+                             / _c;
+        });
         SetBounds(_b, _x, _gridDimensions);
     }
 }
@@ -76,119 +173,203 @@ void Fluid::LinearSolve(int _b, std::vector<float>& _x, std::vector<float>& _xPr
 void Fluid::Project(std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _p, std::vector<float>& _div, int _iterations, int _gridDimensions)
 {
     // Hodge decomposition (incompressible field = current velocities - gradient field)
-    for (int j = 1; j < _gridDimensions - 1; ++j)
+    m_layout.ForEachCell(1, _gridDimensions - 1, [&](int i, int j, int index)
     {
-        for (int i = 1; i < _gridDimensions - 1; ++i)
-        {
-            // Cell is a product of itself and its surrounding neighbours
-            _div[GetGridIndex(i, j)] = -0.5f * (_xVel[GetGridIndex(i + 1, j)] -
-                                                _xVel[GetGridIndex(i - 1, j)] +
-                                                _yVel[GetGridIndex(i, j + 1)] -
-                                                _yVel[GetGridIndex(i, j - 1)])
-                                                / _gridDimensions;
-            _p[GetGridIndex(i, j)] = 0;
-        }
-    }
+        // Cell is a product of itself and its surrounding neighbours
+        _div[index] = -0.5f * (_xVel[m_layout.GetIndex(i + 1, j)] -
+                               _xVel[m_layout.GetIndex(i - 1, j)] +
+                               _yVel[m_layout.GetIndex(i, j + 1)] -
+                               _yVel[m_layout.GetIndex(i, j - 1)])
+                               / _gridDimensions;
+        _p[index] = 0;
+    });
     SetBounds(0, _div, _gridDimensions); 
     SetBounds(0, _p, _gridDimensions);
     LinearSolve(0, _p, _div, 1, 4, _iterations, _gridDimensions);
     
-    for (int j = 1; j < _gridDimensions - 1; ++j)
+    m_layout.ForEachCell(1, _gridDimensions - 1, [&](int i, int j, int index)
     {
-        for (int i = 1; i < _gridDimensions - 1; ++i)
-        {
-            // Product of left and right neighbour
-            _xVel[GetGridIndex(i, j)] -= 0.5f * (_p[GetGridIndex(i + 1, j)] -
-                                                 _p[GetGridIndex(i - 1, j)]) * _gridDimensions;
-            // Product of top and bottom neighbour
-            _yVel[GetGridIndex(i, j)] -= 0.5f * (_p[GetGridIndex(i, j + 1)] -
-                                                 _p[GetGridIndex(i, j - 1)]) * _gridDimensions;
-        }
-    }
+        // Product of left and right neighbour
+        _xVel[index] -= 0.5f * (_p[m_layout.GetIndex(i + 1, j)] -
+                                _p[m_layout.GetIndex(i - 1, j)]) * _gridDimensions;
+        // Product of top and bottom neighbour
+        _yVel[index] -= 0.5f * (_p[m_layout.GetIndex(i, j + 1)] -
+                                _p[m_layout.GetIndex(i, j - 1)]) * _gridDimensions;
+    });
     SetBounds(1, _xVel, _gridDimensions);
     SetBounds(2, _yVel, _gridDimensions);
 }
 
 void Fluid::Advect(int _b, std::vector<float>& _d, std::vector<float>& _d0,  std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions)
 {
-    // Linear backtracing
-    // X
-    float x, s0, s1;
-    int i0, i1;
+    AdvectTarget target = {_b, &_d, &_d0};
+    AdvectFields(&target, 1, _xVel, _yVel, _timeStep, _gridDimensions);
+}
 
-    // Y
-    float y, t0, t1;
-    int j0, j1;
+void Fluid::AdvectFields(AdvectTarget* _targets, int _count, std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions)
+{
+    // Linear backtracing, shared by every target (8 cells at a time when built with AVX2)
+    float* d[m_MAX_ADVECT_TARGETS];
+    const float* d0[m_MAX_ADVECT_TARGETS];
+    for (int first = 0; first < _count; first += m_MAX_ADVECT_TARGETS)
+    {
+        int count = std::min(_count - first, m_MAX_ADVECT_TARGETS);
+        for (int n = 0; n < count; ++n)
+        {
+            d[n] = _targets[first + n].d->data();
+            d0[n] = _targets[first + n].d0->data();
+        }
+        AdvectKernel::Advect(m_layout, _xVel.data(), _yVel.data(), _timeStep, d, d0, count);
+    }
 
-    float timeStep = _timeStep * (_gridDimensions - 2);
-    
-    // Loop all cells (excluding boundaries)
-    for (int j = 1; j < _gridDimensions - 1; ++j)
-    { 
-        for (int i = 1; i < _gridDimensions - 1; ++i)
+    for (int n = 0; n < _count; ++n)
+    {
+        SetBounds(_targets[n].b, *_targets[n].d, _gridDimensions);
+    }
+}
+
+void Fluid::SetSpeciesCount(int _count)
+{
+    m_speciesCount = std::min(std::max(_count, 0), m_MAX_SPECIES);
+    int size = m_speciesCount > 0 ? m_layout.GetStorageSize() * m_MAX_SPECIES : 0;
+    m_speciesPrev = std::vector<float>(size, 0);
+    m_species = std::vector<float>(size, 0);
+}
+
+int Fluid::GetSpeciesCount()
+{
+    return m_speciesCount;
+}
+
+void Fluid::AddSpecies(int _xPos, int _yPos, int _species, float _amount)
+{
+    if (_species < 0 || _species >= m_speciesCount)
+    {
+        return;
+    }
+    _xPos /= m_cellSize;
+    _yPos /= m_cellSize;
+
+    // Constrain to avoid overflow of RGBA values
+    float& value = m_species[GetGridIndex(_xPos, _yPos) * m_MAX_SPECIES + _species];
+    value = std::min(value + _amount, 255.0f);
+}
+
+void Fluid::DiffuseSpecies(std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timestep, int _iterations, int _gridDimensions)
+{
+    float a = _timestep * _amount * (_gridDimensions - 2) * (_gridDimensions - 2);
+    LinearSolveSpecies(_x, _xPrev, a, 1 + 4 * a, _iterations, _gridDimensions);
+}
+
+void Fluid::LinearSolveSpecies(std::vector<float>& _x, std::vector<float>& _xPrev, float _a, float _c, int _iterations, int _gridDimensions)
+{
+    // Same Gauss-Seidel relaxation as LinearSolve, every neighbour load brings in all species at once
+    const int width = m_MAX_SPECIES;
+    float* x = _x.data();
+    const float* xPrev = _xPrev.data();
+    for (int k = 0; k < _iterations; ++k)
+    {
+        m_layout.ForEachCell(1, _gridDimensions - 1, [&](int i, int j, int index)
         {
-            // X
-            x = i - (timeStep * _xVel[GetGridIndex(i, j)]);
-            if (x < 0.5f)
-            {
-                x = 0.5f;
-            }
-            if (x > _gridDimensions + 0.5f)
+            const float* right = x + m_layout.GetIndex(i + 1, j) * width;
+            const float* left = x + m_layout.GetIndex(i - 1, j) * width;
+            const float* down = x + m_layout.GetIndex(i, j + 1) * width;
+            const float* up = x + m_layout.GetIndex(i, j - 1) * width;
+            for (int n = 0; n < width; ++n)
             {
-                x = _gridDimensions + 0.5f;
+                x[index * width + n] = (xPrev[index * width + n] + _a * (right[n] + left[n] + down[n] + up[n])) / _c;
             }
+        });
+        SetSpeciesBounds(_x, _gridDimensions);
+    }
+}
 
-            i0 = int(x);
-            i1 = i0 + 1;
-            s1 = x - i0;
-            s0 = 1.0f - s1;
+void Fluid::AdvectSpecies(std::vector<float>& _d, std::vector<float>& _d0, std::vector<float>& _xVel, std::vector<float>& _yVel, float _timeStep, int _gridDimensions)
+{
+    AdvectKernel::AdvectInterleaved(m_layout, _xVel.data(), _yVel.data(), _timeStep, _d.data(), _d0.data());
+    SetSpeciesBounds(_d, _gridDimensions);
+}
 
-            // Y
-            y = j - (timeStep * _yVel[GetGridIndex(i, j)]);
-            if (y < 0.5f)
-            {
-                y = 0.5f;
-            }
-            if (y > _gridDimensions + 0.5f)
-            {
-                y = _gridDimensions + 0.5f;
-            }
+void Fluid::SetSpeciesBounds(std::vector<float>& _x, int _gridDimensions)
+{
+    // SetBounds(0, ...) for every species
+    const int width = m_MAX_SPECIES;
+    float* x = _x.data();
+    int last = _gridDimensions - 1;
+    m_obstacles.ApplyInterleaved(_x);
 
-            j0 = int(y);
-            j1 = j0 + 1;
-            t1 = y - j0;
-            t0 = 1.0f - t1;
-                
-            // Cell is a product of itself and its surrounding neighbours
-            _d[GetGridIndex(i, j)] = s0 * (t0 * _d0[GetGridIndex(i0, j0)] + t1 * _d0[GetGridIndex(i0, j1)]) +
-                                     s1 * (t0 * _d0[GetGridIndex(i1, j0)] + t1 * _d0[GetGridIndex(i1, j1)]);   
+    auto copy = [&](int _toX, int _toY, int _fromX, int _fromY)
+    {
+        float* to = x + m_layout.GetIndex(_toX, _toY) * width;
+        const float* from = x + m_layout.GetIndex(_fromX, _fromY) * width;
+        for (int n = 0; n < width; ++n)
+        {
+            to[n] = from[n];
+        }
+    };
+    auto corner = [&](int _toX, int _toY, int _aX, int _aY, int _bX, int _bY)
+    {
+        float* to = x + m_layout.GetIndex(_toX, _toY) * width;
+        const float* a = x + m_layout.GetIndex(_aX, _aY) * width;
+        const float* b = x + m_layout.GetIndex(_bX, _bY) * width;
+        for (int n = 0; n < width; ++n)
+        {
+            to[n] = 0.5f * (a[n] + b[n]);
         }
+    };
+
+    for (int i = 1; i < last; ++i)
+    {
+        copy(i, 0, i, 1);
+        copy(i, last, i, last - 1);
+    }
+    for (int j = 1; j < last; ++j)
+    {
+        copy(0, j, 1, j);
+        copy(last, j, last - 1, j);
     }
-    SetBounds(_b, _d, _gridDimensions);
+    corner(0, 0, 1, 0, 0, 1);
+    corner(0, last, 1, last, 0, last - 1);
+    corner(last, 0, last - 1, 0, last, 1);
+    corner(last, last, last - 1, last, last, last - 1);
+}
+
+const std::vector<float>& Fluid::GetSpecies()
+{
+    return m_species;
 }
 
 void Fluid::SetBounds(int _b, std::vector<float>& _x, int _gridDimensions)
 {
-    // Sets the velocity of the boundary cells, equal to the reverse incoming velocity (repelling the fluid)
+    float* x = _x.data();
+    int last = _gridDimensions - 1;
+
+    // Internal obstacles first, so the outer walls see their final values
+    m_obstacles.Apply(_b, _x);
+
+    // Sets the velocity of the boundary cells, equal to the reverse incoming velocity (repelling the fluid).
+    // The sign only depends on _b, so it is picked once rather than per cell
+    float xSign = _b == 1 ? -1.0f : 1.0f;
+    float ySign = _b == 2 ? -1.0f : 1.0f;
 
     // Top and bottom cases
-    for (int i = 1; i < _gridDimensions - 1; ++i)
+    for (int i = 1; i < last; ++i)
     {
-        _x[GetGridIndex(i, 0)] = _b == 2 ? -_x[GetGridIndex(i, 1)] : _x[GetGridIndex(i, 1)];
-        _x[GetGridIndex(i, _gridDimensions - 1)] = _b == 2 ? -_x[GetGridIndex(i, _gridDimensions - 2)] : _x[GetGridIndex(i, _gridDimensions - 2)];
+        x[m_layout.GetIndex(i, 0)] = ySign * x[m_layout.GetIndex(i, 1)];
+        x[m_layout.GetIndex(i, last)] = ySign * x[m_layout.GetIndex(i, last - 1)];
     }
     // Left and right cases
-    for (int j = 1; j < _gridDimensions - 1; ++j)
+    for (int j = 1; j < last; ++j)
     {
-        _x[GetGridIndex(0, j)] = _b == 1 ? -_x[GetGridIndex(1, j)] : _x[GetGridIndex(1, j)];
-        _x[GetGridIndex(_gridDimensions - 1, j)] = _b == 1 ? -_x[GetGridIndex(_gridDimensions - 2, j)] : _x[GetGridIndex(_gridDimensions - 2, j)];
+        x[m_layout.GetIndex(0, j)] = xSign * x[m_layout.GetIndex(1, j)];
+        x[m_layout.GetIndex(last, j)] = xSign * x[m_layout.GetIndex(last - 1, j)];
     }
     
     // Corner cases (TL, TR, BL, BR)
-    _x[GetGridIndex(0, 0)] = 0.5f * (_x[GetGridIndex(1, 0)] + _x[GetGridIndex(0, 1)]);
-    _x[GetGridIndex(0, _gridDimensions - 1)] = 0.5f * (_x[GetGridIndex(1, _gridDimensions - 1)] + _x[GetGridIndex(0, _gridDimensions - 2)]);
-    _x[GetGridIndex(_gridDimensions - 1, 0)] = 0.5f * (_x[GetGridIndex(_gridDimensions - 2, 0)] + _x[GetGridIndex(_gridDimensions - 1, 1)]);
-    _x[GetGridIndex(_gridDimensions - 1, _gridDimensions - 1)] = 0.5f * (_x[GetGridIndex(_gridDimensions - 2, _gridDimensions - 1)] + _x[GetGridIndex(_gridDimensions - 1, _gridDimensions - 2)]);
+    x[m_layout.GetIndex(0, 0)] = 0.5f * (x[m_layout.GetIndex(1, 0)] + x[m_layout.GetIndex(0, 1)]);
+    x[m_layout.GetIndex(0, last)] = 0.5f * (x[m_layout.GetIndex(1, last)] + x[m_layout.GetIndex(0, last - 1)]);
+    x[m_layout.GetIndex(last, 0)] = 0.5f * (x[m_layout.GetIndex(last - 1, 0)] + x[m_layout.GetIndex(last, 1)]);
+    x[m_layout.GetIndex(last, last)] = 0.5f * (x[m_layout.GetIndex(last - 1, last)] + x[m_layout.GetIndex(last, last - 1)]);
 }
 
 void Fluid::Fade(float _fadeRate)
@@ -206,6 +387,10 @@ void Fluid::Fade(float _fadeRate)
             m_density[i] = 255;
         }
     }
+    for (float& value : m_species)
+    {
+        value = std::min(std::max(value - _fadeRate, 0.0f), 255.0f);
+    }
 }
 
 void Fluid::ShowGrid()
@@ -244,21 +429,110 @@ void Fluid::ShowVelocity()
 
 void Fluid::Update()
 {
+    // Obstacles painted or loaded since the last step
+    if (m_obstacles.IsDirty())
+    {
+        m_obstacles.Compile(m_layout, m_cellSize);
+    }
+    if (m_statsEnabled)
+    {
+        m_stageStart = std::chrono::steady_clock::now();
+    }
+
     // Update velocity
-    Diffuse(1, m_xVelPrev, m_xVel, m_viscosity, m_timeStep, 4, m_gridDimensions);           // Diffuse velocity
-    Diffuse(2, m_yVelPrev, m_yVel, m_viscosity, m_timeStep, 4, m_gridDimensions);           // ...
-    Project(m_xVelPrev, m_yVelPrev, m_xVel, m_yVel, 4, m_gridDimensions);                   // Make incompressible
-    Advect(1, m_xVel, m_xVelPrev, m_xVelPrev, m_yVelPrev, m_timeStep, m_gridDimensions);    // Trace back original position
-    Advect(2, m_yVel, m_yVelPrev, m_xVelPrev, m_yVelPrev, m_timeStep, m_gridDimensions);    // ...
-    Project(m_xVel, m_yVel, m_xVelPrev, m_yVelPrev, 4, m_gridDimensions);                   // Make incompressible
+    Diffuse(1, m_xVelPrev, m_xVel, m_viscosity, m_timeStep, m_SOLVER_ITERATIONS, m_gridDimensions);    // Diffuse velocity
+    Diffuse(2, m_yVelPrev, m_yVel, m_viscosity, m_timeStep, m_SOLVER_ITERATIONS, m_gridDimensions);    // ...
+    EndStage(SolverStage::VelocityDiffuse);
+    Project(m_xVelPrev, m_yVelPrev, m_xVel, m_yVel, m_SOLVER_ITERATIONS, m_gridDimensions);            // Make incompressible
+    EndStage(SolverStage::VelocityProject);
+    AdvectTarget velocity[] = {{1, &m_xVel, &m_xVelPrev}, {2, &m_yVel, &m_yVelPrev}};
+    AdvectFields(velocity, 2, m_xVelPrev, m_yVelPrev, m_timeStep, m_gridDimensions);                 // Trace back original position (both components, one backtrace)
+    EndStage(SolverStage::VelocityAdvect);
+    Project(m_xVel, m_yVel, m_xVelPrev, m_yVelPrev, m_SOLVER_ITERATIONS, m_gridDimensions);            // Make incompressible
+    EndStage(SolverStage::VelocityReproject);
     
     // Update density
-    Diffuse(0, m_prevDensity, m_density, m_diffusion, m_timeStep, 4, m_gridDimensions);     // Diffuse density
-    Advect(0, m_density, m_prevDensity, m_xVel, m_yVel, m_timeStep, m_gridDimensions);      // Trace back original position
+    Diffuse(0, m_prevDensity, m_density, m_diffusion, m_timeStep, m_SOLVER_ITERATIONS, m_gridDimensions);  // Diffuse density
+    EndStage(SolverStage::DensityDiffuse);
+    Advect(0, m_density, m_prevDensity, m_xVel, m_yVel, m_timeStep, m_gridDimensions);               // Trace back original position
+    EndStage(SolverStage::DensityAdvect);
+
+    // Update species (all of them per sweep)
+    if (m_speciesCount > 0)
+    {
+        DiffuseSpecies(m_speciesPrev, m_species, m_diffusion, m_timeStep, m_SOLVER_ITERATIONS, m_gridDimensions);
+        AdvectSpecies(m_species, m_speciesPrev, m_xVel, m_yVel, m_timeStep, m_gridDimensions);
+    }
+    EndStage(SolverStage::Species);
+
+    if (m_statsEnabled)
+    {
+        CollectStats();
+    }
+}
+
+void Fluid::EndStage(SolverStage _stage)
+{
+    if (m_statsEnabled)
+    {
+        auto now = std::chrono::steady_clock::now();
+        m_stats.stageMs[int(_stage)] = std::chrono::duration<double, std::milli>(now - m_stageStart).count();
+        m_stageStart = now;
+    }
+}
+
+void Fluid::CollectStats()
+{
+    m_stats.gridDimensions = m_gridDimensions;
+    m_stats.iterations = m_SOLVER_ITERATIONS;
+
+    // The final Project leaves pressure in m_xVelPrev and its divergence source in m_yVelPrev
+    const std::vector<float>& p = m_xVelPrev;
+    const std::vector<float>& div = m_yVelPrev;
+    double residual = 0.0;
+    double divergence = 0.0;
+    double density = 0.0;
+    float maxVelocitySquared = 0.0f;
+    m_layout.ForEachCell(1, m_gridDimensions - 1, [&](int i, int j, int index)
+    {
+        float r = div[index] + p[m_layout.GetIndex(i + 1, j)] + p[m_layout.GetIndex(i - 1, j)] +
+                  p[m_layout.GetIndex(i, j + 1)] + p[m_layout.GetIndex(i, j - 1)] - 4.0f * p[index];
+        residual += r * r;
+
+        float d = 0.5f * (m_xVel[m_layout.GetIndex(i + 1, j)] - m_xVel[m_layout.GetIndex(i - 1, j)] +
+                          m_yVel[m_layout.GetIndex(i, j + 1)] - m_yVel[m_layout.GetIndex(i, j - 1)]);
+        divergence += d * d;
+
+        density += m_density[index];
+        maxVelocitySquared = std::max(maxVelocitySquared, m_xVel[index] * m_xVel[index] + m_yVel[index] * m_yVel[index]);
+    });
+
+    double cells = double(m_gridDimensions - 2) * (m_gridDimensions - 2);
+    m_stats.pressureResidual = float(std::sqrt(residual / cells));
+    m_stats.divergence = float(std::sqrt(divergence / cells));
+    m_stats.totalDensity = float(density);
+    m_stats.maxVelocity = std::sqrt(maxVelocitySquared);
+}
+
+void Fluid::SetStatsEnabled(bool _enabled)
+{
+    m_statsEnabled = _enabled;
+}
+
+const FluidStats& Fluid::GetStats()
+{
+    return m_stats;
 }
 
 void Fluid::Draw()
 {
+    if (m_speciesCount > 0)
+    {
+        DrawSpecies();
+        m_obstacles.Draw(m_renderer, m_cellSize);
+        return;
+    }
+
     for (int y = 0; y < m_gridDimensions; ++y)
     {
         for (int x = 0; x < m_gridDimensions; ++x)
@@ -274,6 +548,50 @@ void Fluid::Draw()
 			SDL_RenderFillRect(m_renderer, &cell);
         }
     }
+    m_obstacles.Draw(m_renderer, m_cellSize);
+}
+
+void Fluid::DrawSpecies()
+{
+    // Species colours (red, green, blue, white), scaled by concentration and summed
+    static const float palette[m_MAX_SPECIES][3] = {{1.0f, 0.25f, 0.1f}, {0.2f, 1.0f, 0.3f}, {0.2f, 0.4f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+
+    if (m_speciesTexture == NULL || m_textureDimensions != m_gridDimensions)
+    {
+        if (m_speciesTexture != NULL)
+        {
+            SDL_DestroyTexture(m_speciesTexture);
+        }
+        m_textureDimensions = m_gridDimensions;
+        m_speciesTexture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, m_gridDimensions, m_gridDimensions);
+        SDL_SetTextureBlendMode(m_speciesTexture, SDL_BLENDMODE_ADD);
+        m_speciesPixels = std::vector<Uint32>(m_gridDimensions * m_gridDimensions, 0);
+    }
+
+    for (int y = 0; y < m_gridDimensions; ++y)
+    {
+        for (int x = 0; x < m_gridDimensions; ++x)
+        {
+            const float* species = &m_species[m_layout.GetIndex(x, y) * m_MAX_SPECIES];
+            float colour[3] = {0.0f, 0.0f, 0.0f};
+            for (int n = 0; n < m_speciesCount; ++n)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    colour[c] += palette[n][c] * species[n];
+                }
+            }
+            Uint32 r = Uint32(std::min(colour[0], 255.0f));
+            Uint32 g = Uint32(std::min(colour[1], 255.0f));
+            Uint32 b = Uint32(std::min(colour[2], 255.0f));
+            m_speciesPixels[x + y * m_gridDimensions] = 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    // Stretched over the window in one copy
+    SDL_UpdateTexture(m_speciesTexture, NULL, m_speciesPixels.data(), m_gridDimensions * int(sizeof(Uint32)));
+    SDL_Rect area = {0, 0, m_gridDimensions * m_cellSize, m_gridDimensions * m_cellSize};
+    SDL_RenderCopy(m_renderer, m_speciesTexture, NULL, &area);
 }
 
 void Fluid::ChangeResolution(bool _scale)
@@ -298,19 +616,162 @@ void Fluid::ChangeResolution(bool _scale)
 
 void Fluid::Reset()
 {
+    // Rebuild layout for the current resolution (tiled storage is padded to whole tiles)
+    m_layout = GridLayout(m_layout.GetLayout(), m_gridDimensions);
+    int size = m_layout.GetStorageSize();
+
     // Reset all fluids values back to 0
-    m_prevDensity = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
-    m_density = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
-    m_xVelPrev = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
-    m_yVelPrev = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
-    m_xVel = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
-    m_yVel = std::vector<float>(m_gridDimensions * m_gridDimensions, 0);
+    m_prevDensity = std::vector<float>(size, 0);
+    m_density = std::vector<float>(size, 0);
+    m_xVelPrev = std::vector<float>(size, 0);
+    m_yVelPrev = std::vector<float>(size, 0);
+    m_xVel = std::vector<float>(size, 0);
+    m_yVel = std::vector<float>(size, 0);
+    SetSpeciesCount(m_speciesCount);
+
+    // Rasterise obstacles onto the new grid
+    m_obstacles.Compile(m_layout, m_cellSize);
+}
+
+bool Fluid::SaveSnapshot(std::string _path)
+{
+    SnapshotHeader header = Snapshot::CreateHeader();
+    header.gridDimensions = uint32_t(m_gridDimensions);
+    header.layout = uint32_t(m_layout.GetLayout());
+    header.storageSize = uint32_t(m_layout.GetStorageSize());
+    header.cellSize = m_cellSize;
+    header.scaleFactor = m_scaleFactor;
+    header.timeStep = m_timeStep;
+    header.diffusion = m_diffusion;
+    header.viscosity = m_viscosity;
+    header.fieldCount = m_speciesCount > 0 ? 8 : 6;
+    header.speciesCount = uint32_t(m_speciesCount);
+    header.speciesWidth = m_speciesCount > 0 ? m_MAX_SPECIES : 0;
+
+    // Order matches SnapshotField. The previous fields are the solver's initial guesses, so they are kept for an exact resume
+    const float* fields[] = {m_density.data(), m_xVel.data(), m_yVel.data(), m_prevDensity.data(), m_xVelPrev.data(), m_yVelPrev.data(),
+                             m_species.data(), m_speciesPrev.data()};
+    return Snapshot::Save(_path, header, fields);
+}
+
+bool Fluid::LoadSnapshot(std::string _path)
+{
+    Snapshot snapshot;
+    return snapshot.Open(_path) && AdoptSnapshot(snapshot, _path);
+}
+
+bool Fluid::LoadSnapshot(const std::vector<uint8_t>& _data, std::string _name)
+{
+    Snapshot snapshot;
+    return snapshot.Open(_data.data(), _data.size(), _name) && AdoptSnapshot(snapshot, _name);
+}
+
+bool Fluid::AdoptSnapshot(Snapshot& _snapshot, std::string _name)
+{
+    const SnapshotHeader* header = _snapshot.GetHeader();
+    if (header->layout > uint32_t(MemoryLayout::Tiled) || header->gridDimensions < 3 || header->fieldCount < 6)
+    {
+        std::cout << "Snapshot has an invalid grid: " << _name << "\n";
+        return false;
+    }
+    // The grid's fields have to fit in the file before the grid is built (64-bit, divided rather than multiplied so it can't overflow)
+    uint64_t cells = uint64_t(header->gridDimensions) * header->gridDimensions;
+    if (cells > _snapshot.GetSize() / (uint64_t(header->fieldCount) * sizeof(float)))
+    {
+        std::cout << "Snapshot is truncated: " << _name << "\n";
+        return false;
+    }
+    // The grid has to cover this window exactly, as every resolution ChangeResolution() steps through does
+    if (int64_t(header->cellSize) * header->gridDimensions != m_screenDimensions)
+    {
+        std::cout << "Snapshot grid doesn't fit this window (" << header->gridDimensions << " cells of " << header->cellSize << " pixels): " << _name << "\n";
+        return false;
+    }
+    if (header->scaleFactor < 2 || header->scaleFactor > 5 || !std::isfinite(header->timeStep) || !std::isfinite(header->diffusion) || !std::isfinite(header->viscosity))
+    {
+        std::cout << "Snapshot has invalid solver parameters: " << _name << "\n";
+        return false;
+    }
+    GridLayout layout(MemoryLayout(header->layout), int(header->gridDimensions));
+    if (uint32_t(layout.GetStorageSize()) != header->storageSize)
+    {
+        std::cout << "Snapshot field size doesn't match its grid: " << _name << "\n";
+        return false;
+    }
+
+    // Adopt the snapshot's grid and parameters
+    m_gridDimensions = int(header->gridDimensions);
+    m_cellSize = header->cellSize;
+    m_scaleFactor = header->scaleFactor;
+    m_timeStep = header->timeStep;
+    m_diffusion = header->diffusion;
+    m_viscosity = header->viscosity;
+    m_layout = layout;
+
+    // Copy straight out of the mapping (reuses the existing allocations when the grid size hasn't changed)
+    int size = int(header->storageSize);
+    auto load = [&](std::vector<float>& _field, SnapshotField _source)
+    {
+        const float* data = _snapshot.GetField(_source);
+        _field.assign(data, data + size);
+    };
+    load(m_density, SnapshotField::Density);
+    load(m_xVel, SnapshotField::XVelocity);
+    load(m_yVel, SnapshotField::YVelocity);
+    load(m_prevDensity, SnapshotField::PrevDensity);
+    load(m_xVelPrev, SnapshotField::PrevXVelocity);
+    load(m_yVelPrev, SnapshotField::PrevYVelocity);
+
+    // Species, when the snapshot has them (zeroed otherwise, on the snapshot's grid)
+    bool hasSpecies = header->speciesCount > 0 && header->fieldCount > uint32_t(SnapshotField::PrevSpecies);
+    if (hasSpecies && header->speciesCount <= uint32_t(m_MAX_SPECIES) && header->speciesWidth == uint32_t(m_MAX_SPECIES))
+    {
+        SetSpeciesCount(int(header->speciesCount));
+        const float* species = _snapshot.GetField(SnapshotField::Species);
+        const float* speciesPrev = _snapshot.GetField(SnapshotField::PrevSpecies);
+        m_species.assign(species, species + size * m_MAX_SPECIES);
+        m_speciesPrev.assign(speciesPrev, speciesPrev + size * m_MAX_SPECIES);
+    }
+    else
+    {
+        if (hasSpecies)
+        {
+            std::cout << "Snapshot species don't match this build (" << header->speciesCount << " x " << header->speciesWidth << "), dye species start empty\n";
+        }
+        else if (m_speciesCount > 0 && header->version < 2)
+        {
+            std::cout << "Snapshot version " << header->version << " doesn't store dye species, they start empty\n";
+        }
+        else if (m_speciesCount > 0)
+        {
+            std::cout << "Snapshot has no dye species, they start empty\n";
+        }
+        SetSpeciesCount(m_speciesCount);
+    }
+
+    m_obstacles.Compile(m_layout, m_cellSize);
+    return true;
+}
+
+bool Fluid::LoadObstacles(std::string _path)
+{
+    return m_obstacles.LoadMask(_path, m_screenDimensions);
+}
+
+void Fluid::PaintObstacle(int _xPos, int _yPos, int _radius, bool _solid)
+{
+    m_obstacles.Paint(_xPos, _yPos, _radius, _solid, m_screenDimensions);
 }
 
 void Fluid::Destroy()
 {
     // Free loaded image
     m_arrow.Free();
+    if (m_speciesTexture != NULL)
+    {
+        SDL_DestroyTexture(m_speciesTexture);
+        m_speciesTexture = NULL;
+    }
 }
 
 int Fluid::GetGridIndex(int _xPos, int _yPos)
@@ -334,5 +795,78 @@ int Fluid::GetGridIndex(int _xPos, int _yPos)
         _yPos = 0;
     }
 
-    return _xPos + (_yPos * m_gridDimensions);
+    return m_layout.GetIndex(_xPos, _yPos);
+}
+
+MemoryLayout Fluid::GetMemoryLayout()
+{
+    return m_layout.GetLayout();
+}
+
+const GridLayout& Fluid::GetGridLayout()
+{
+    return m_layout;
+}
+
+int Fluid::GetGridDimensions()
+{
+    return m_gridDimensions;
+}
+
+const std::vector<float>& Fluid::GetDensity()
+{
+    return m_density;
+}
+
+const std::vector<float>& Fluid::GetXVelocity()
+{
+    return m_xVel;
+}
+
+const std::vector<float>& Fluid::GetYVelocity()
+{
+    return m_yVel;
+}
+
+uint64_t Fluid::GetStateHash()
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::vector<float>* field : {&m_density, &m_xVel, &m_yVel})
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(field->data());
+        for (size_t i = 0; i < field->size() * sizeof(float); ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+void Fluid::SetState(int _gridDimensions, MemoryLayout _layout, const std::vector<float>& _density, const std::vector<float>* _xVel, const std::vector<float>* _yVel)
+{
+    if (_gridDimensions != m_gridDimensions || _layout != m_layout.GetLayout())
+    {
+        m_gridDimensions = _gridDimensions;
+        m_cellSize = std::max(1, m_screenDimensions / m_gridDimensions);
+        // Arrow scale follows cell size (32 pixels = 5 ... 4 pixels = 2)
+        m_scaleFactor = 2;
+        while (m_scaleFactor < 5 && (4 << (m_scaleFactor - 2)) < m_cellSize)
+        {
+            m_scaleFactor++;
+        }
+        m_layout = GridLayout(_layout, m_gridDimensions);
+        Reset();
+    }
+
+    m_density.assign(_density.begin(), _density.end());
+    if (_xVel != NULL && _yVel != NULL)
+    {
+        m_xVel.assign(_xVel->begin(), _xVel->end());
+        m_yVel.assign(_yVel->begin(), _yVel->end());
+    }
+    else
+    {
+        std::fill(m_xVel.begin(), m_xVel.end(), 0.0f);
+        std::fill(m_yVel.begin(), m_yVel.end(), 0.0f);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,416 @@
+///
+/// @file Fluid3D.cpp
+/// @brief Volumetric (3D) variant of Fluid with cache-blocked, multithreaded kernels
+
+#include "Fluid3D.h"
+
+#include <algorithm>
+
+Fluid3D::Fluid3D(int _gridDimensions, float _timeStep, float _diffusion, float _viscosity, SDL_Renderer* _renderer, int _threads)
+    : m_threads(_threads)
+{
+    m_gridDimensions = _gridDimensions;
+    m_timeStep = _timeStep;
+    m_diffusion = _diffusion;
+    m_viscosity = _viscosity;
+    m_renderer = _renderer;
+    m_slice = m_gridDimensions / 2;
+    Reset();
+}
+
+void Fluid3D::AddDensity(int _xPos, int _yPos, int _zPos, float _amount)
+{
+    int index = GetClampedIndex(_xPos, _yPos, _zPos);
+    // Constrain density to avoid overflow of RGBA values
+    m_density[index] = std::min(m_density[index] + _amount, 255.0f);
+}
+
+void Fluid3D::AddVelocity(int _xPos, int _yPos, int _zPos, float _amountX, float _amountY, float _amountZ)
+{
+    int index = GetClampedIndex(_xPos, _yPos, _zPos);
+    m_xVel[index] += _amountX;
+    m_yVel[index] += _amountY;
+    m_zVel[index] += _amountZ;
+}
+
+template <typename Func>
+void Fluid3D::ForEachBlock(Func _func)
+{
+    const int zChunk = 8;
+    int yBlocks = (m_gridDimensions - 2 + m_BLOCK_ROWS - 1) / m_BLOCK_ROWS;
+    int zChunks = (m_gridDimensions - 2 + zChunk - 1) / zChunk;
+
+    // One task per (block of rows, run of planes)
+    m_threads.ParallelFor(0, yBlocks * zChunks, [&](int _begin, int _end)
+    {
+        for (int task = _begin; task < _end; ++task)
+        {
+            int yBegin = 1 + (task % yBlocks) * m_BLOCK_ROWS;
+            int yEnd = std::min(yBegin + m_BLOCK_ROWS, m_gridDimensions - 1);
+            int zBegin = 1 + (task / yBlocks) * zChunk;
+            int zEnd = std::min(zBegin + zChunk, m_gridDimensions - 1);
+            for (int z = zBegin; z < zEnd; ++z)
+            {
+                _func(z, yBegin, yEnd);
+            }
+        }
+    });
+}
+
+void Fluid3D::Diffuse(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _amount, float _timeStep, int _iterations)
+{
+    float a = _timeStep * _amount * (m_gridDimensions - 2) * (m_gridDimensions - 2);
+    LinearSolve(_b, _x, _xPrev, a, 1 + 6 * a, _iterations);
+}
+
+void Fluid3D::LinearSolve(int _b, std::vector<float>& _x, std::vector<float>& _xPrev, float _a, float _c, int _iterations)
+{
+    const int n = m_gridDimensions;
+    const int plane = n * n;
+    const float cInverse = 1.0f / _c;
+    float* x = _x.data();
+    const float* xPrev = _xPrev.data();
+
+    for (int k = 0; k < _iterations; ++k)
+    {
+        // Red-black Gauss-Seidel, cells of one colour only read cells of the other
+        for (int colour = 0; colour < 2; ++colour)
+        {
+            ForEachBlock([&](int z, int yBegin, int yEnd)
+            {
+                for (int y = yBegin; y < yEnd; ++y)
+                {
+                    // First interior x with (x + y + z) of this colour's parity
+                    int start = 1 + (((1 + y + z) & 1) ^ colour);
+                    int row = GetGridIndex(0, y, z);
+                    for (int i = start; i < n - 1; i += 2)
+                    {
+                        int index = row + i;
+                        x[index] = (xPrev[index] + _a *
+                                       (x[index + 1] + x[index - 1] +           // Right, left
+                                        x[index + n] + x[index - n] +           // Down, up
+                                        x[index + plane] + x[index - plane]))   // Back, front
+                                       * cInverse;
+                    }
+                }
+            });
+        }
+        SetBounds(_b, _x);
+    }
+}
+
+void Fluid3D::Project(std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _zVel, std::vector<float>& _p, std::vector<float>& _div, int _iterations)
+{
+    const int n = m_gridDimensions;
+    const int plane = n * n;
+
+    ForEachBlock([&](int z, int yBegin, int yEnd)
+    {
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            int row = GetGridIndex(0, y, z);
+            for (int i = 1; i < n - 1; ++i)
+            {
+                int index = row + i;
+                _div[index] = -0.5f * (_xVel[index + 1] - _xVel[index - 1] +
+                                       _yVel[index + n] - _yVel[index - n] +
+                                       _zVel[index + plane] - _zVel[index - plane]) / n;
+                _p[index] = 0;
+            }
+        }
+    });
+    SetBounds(0, _div);
+    SetBounds(0, _p);
+    LinearSolve(0, _p, _div, 1, 6, _iterations);
+
+    ForEachBlock([&](int z, int yBegin, int yEnd)
+    {
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            int row = GetGridIndex(0, y, z);
+            for (int i = 1; i < n - 1; ++i)
+            {
+                int index = row + i;
+                _xVel[index] -= 0.5f * (_p[index + 1] - _p[index - 1]) * n;
+                _yVel[index] -= 0.5f * (_p[index + n] - _p[index - n]) * n;
+                _zVel[index] -= 0.5f * (_p[index + plane] - _p[index - plane]) * n;
+            }
+        }
+    });
+    SetBounds(1, _xVel);
+    SetBounds(2, _yVel);
+    SetBounds(3, _zVel);
+}
+
+void Fluid3D::Advect(const int* _b, std::vector<float>* const* _d, std::vector<float>* const* _d0, int _count,
+                     std::vector<float>& _xVel, std::vector<float>& _yVel, std::vector<float>& _zVel, float _timeStep)
+{
+    const int n = m_gridDimensions;
+    const float timeStep = _timeStep * (n - 2);
+    const float upper = n + 0.5f;
+
+    ForEachBlock([&](int z, int yBegin, int yEnd)
+    {
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            int row = GetGridIndex(0, y, z);
+            for (int i = 1; i < n - 1; ++i)
+            {
+                int index = row + i;
+
+                // Linear backtracing, shared by every field
+                float x = std::min(std::max(i - timeStep * _xVel[index], 0.5f), upper);
+                float yBack = std::min(std::max(y - timeStep * _yVel[index], 0.5f), upper);
+                float zBack = std::min(std::max(z - timeStep * _zVel[index], 0.5f), upper);
+
+                int i0 = int(x);
+                int j0 = int(yBack);
+                int k0 = int(zBack);
+                float s1 = x - i0;
+                float t1 = yBack - j0;
+                float u1 = zBack - k0;
+                float s0 = 1.0f - s1;
+                float t0 = 1.0f - t1;
+                float u0 = 1.0f - u1;
+
+                // Constrain neighbours to the grid
+                int i1 = std::min(i0 + 1, n - 1);
+                int j1 = std::min(j0 + 1, n - 1);
+                int k1 = std::min(k0 + 1, n - 1);
+                i0 = std::min(i0, n - 1);
+                j0 = std::min(j0, n - 1);
+                k0 = std::min(k0, n - 1);
+
+                int index000 = GetGridIndex(i0, j0, k0);
+                int index010 = GetGridIndex(i0, j1, k0);
+                int index001 = GetGridIndex(i0, j0, k1);
+                int index011 = GetGridIndex(i0, j1, k1);
+                int xStep = i1 - i0;
+
+                for (int f = 0; f < _count; ++f)
+                {
+                    const float* d0 = _d0[f]->data();
+                    (*_d[f])[index] = s0 * (t0 * (u0 * d0[index000] + u1 * d0[index001]) +
+                                            t1 * (u0 * d0[index010] + u1 * d0[index011])) +
+                                      s1 * (t0 * (u0 * d0[index000 + xStep] + u1 * d0[index001 + xStep]) +
+                                            t1 * (u0 * d0[index010 + xStep] + u1 * d0[index011 + xStep]));
+                }
+            }
+        }
+    });
+
+    for (int f = 0; f < _count; ++f)
+    {
+        SetBounds(_b[f], *_d[f]);
+    }
+}
+
+void Fluid3D::SetBounds(int _b, std::vector<float>& _x)
+{
+    const int n = m_gridDimensions;
+    const int plane = n * n;
+    float* x = _x.data();
+
+    // Faces reflect the velocity component normal to them (repelling the fluid), everything else is copied
+    const float xSign = _b == 1 ? -1.0f : 1.0f;
+    const float ySign = _b == 2 ? -1.0f : 1.0f;
+    const float zSign = _b == 3 ? -1.0f : 1.0f;
+
+    m_threads.ParallelFor(1, n - 1, [&](int _begin, int _end)
+    {
+        for (int j = _begin; j < _end; ++j)
+        {
+            for (int i = 1; i < n - 1; ++i)
+            {
+                // Front and back (z)
+                x[GetGridIndex(i, j, 0)] = zSign * x[GetGridIndex(i, j, 1)];
+                x[GetGridIndex(i, j, n - 1)] = zSign * x[GetGridIndex(i, j, n - 2)];
+                // Top and bottom (y)
+                x[GetGridIndex(i, 0, j)] = ySign * x[GetGridIndex(i, 1, j)];
+                x[GetGridIndex(i, n - 1, j)] = ySign * x[GetGridIndex(i, n - 2, j)];
+                // Left and right (x)
+                x[GetGridIndex(0, i, j)] = xSign * x[GetGridIndex(1, i, j)];
+                x[GetGridIndex(n - 1, i, j)] = xSign * x[GetGridIndex(n - 2, i, j)];
+            }
+        }
+    });
+
+    // Edges average their two face neighbours
+    for (int i = 1; i < n - 1; ++i)
+    {
+        for (int a = 0; a < 2; ++a)
+        {
+            for (int c = 0; c < 2; ++c)
+            {
+                int edge = a * (n - 1);
+                int side = c * (n - 1);
+                int inA = a ? -1 : 1;
+                int inC = c ? -1 : 1;
+
+                // Along x (y = edge, z = side)
+                int index = GetGridIndex(i, edge, side);
+                x[index] = 0.5f * (x[index + inA * n] + x[index + inC * plane]);
+                // Along y (x = edge, z = side)
+                index = GetGridIndex(edge, i, side);
+                x[index] = 0.5f * (x[index + inA] + x[index + inC * plane]);
+                // Along z (x = edge, y = side)
+                index = GetGridIndex(edge, side, i);
+                x[index] = 0.5f * (x[index + inA] + x[index + inC * n]);
+            }
+        }
+    }
+
+    // Corners average their three edge neighbours
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        int i = (corner & 1) ? n - 1 : 0;
+        int j = (corner & 2) ? n - 1 : 0;
+        int k = (corner & 4) ? n - 1 : 0;
+        int index = GetGridIndex(i, j, k);
+        x[index] = (x[index + ((corner & 1) ? -1 : 1)] +
+                    x[index + ((corner & 2) ? -n : n)] +
+                    x[index + ((corner & 4) ? -plane : plane)]) / 3.0f;
+    }
+}
+
+void Fluid3D::Fade(float _fadeRate)
+{
+    float* density = m_density.data();
+    m_threads.ParallelFor(0, int(m_density.size()), [&](int _begin, int _end)
+    {
+        for (int i = _begin; i < _end; ++i)
+        {
+            // Constrain density to avoid overflow of RGBA values
+            density[i] = std::min(std::max(density[i] - _fadeRate, 0.0f), 255.0f);
+        }
+    });
+}
+
+void Fluid3D::Update()
+{
+    // Update velocity
+    Diffuse(1, m_xVelPrev, m_xVel, m_viscosity, m_timeStep, 4);        // Diffuse velocity
+    Diffuse(2, m_yVelPrev, m_yVel, m_viscosity, m_timeStep, 4);        // ...
+    Diffuse(3, m_zVelPrev, m_zVel, m_viscosity, m_timeStep, 4);        // ...
+    Project(m_xVelPrev, m_yVelPrev, m_zVelPrev, m_xVel, m_yVel, 4);    // Make incompressible
+
+    int velocityBounds[] = {1, 2, 3};
+    std::vector<float>* velocity[] = {&m_xVel, &m_yVel, &m_zVel};
+    std::vector<float>* velocityPrev[] = {&m_xVelPrev, &m_yVelPrev, &m_zVelPrev};
+    Advect(velocityBounds, velocity, velocityPrev, 3, m_xVelPrev, m_yVelPrev, m_zVelPrev, m_timeStep);   // Trace back original position
+    Project(m_xVel, m_yVel, m_zVel, m_xVelPrev, m_yVelPrev, 4);       // Make incompressible
+
+    // Update density
+    Diffuse(0, m_prevDensity, m_density, m_diffusion, m_timeStep, 4);
+    int densityBounds[] = {0};
+    std::vector<float>* density[] = {&m_density};
+    std::vector<float>* densityPrev[] = {&m_prevDensity};
+    Advect(densityBounds, density, densityPrev, 1, m_xVel, m_yVel, m_zVel, m_timeStep);
+}
+
+void Fluid3D::Draw()
+{
+    const int n = m_gridDimensions;
+    if (m_texture == NULL)
+    {
+        m_texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, n, n);
+        m_pixels = std::vector<Uint32>(n * n, 0);
+    }
+
+    // One grey pixel per (x, y) column
+    m_threads.ParallelFor(0, n, [&](int _begin, int _end)
+    {
+        for (int y = _begin; y < _end; ++y)
+        {
+            for (int x = 0; x < n; ++x)
+            {
+                float density = 0;
+                if (m_maxProjection)
+                {
+                    for (int z = 0; z < n; ++z)
+                    {
+                        density = std::max(density, m_density[GetGridIndex(x, y, z)]);
+                    }
+                }
+                else
+                {
+                    density = m_density[GetGridIndex(x, y, m_slice)];
+                }
+                Uint32 value = Uint32(std::min(std::max(density, 0.0f), 255.0f));
+                m_pixels[x + y * n] = 0xFF000000 | (value << 16) | (value << 8) | value;
+            }
+        }
+    });
+
+    SDL_UpdateTexture(m_texture, NULL, m_pixels.data(), n * int(sizeof(Uint32)));
+    SDL_RenderCopy(m_renderer, m_texture, NULL, NULL);
+}
+
+void Fluid3D::Reset()
+{
+    // Reset all fluids values back to 0
+    int size = m_gridDimensions * m_gridDimensions * m_gridDimensions;
+    m_prevDensity = std::vector<float>(size, 0);
+    m_density = std::vector<float>(size, 0);
+    m_xVelPrev = std::vector<float>(size, 0);
+    m_yVelPrev = std::vector<float>(size, 0);
+    m_zVelPrev = std::vector<float>(size, 0);
+    m_xVel = std::vector<float>(size, 0);
+    m_yVel = std::vector<float>(size, 0);
+    m_zVel = std::vector<float>(size, 0);
+}
+
+void Fluid3D::Destroy()
+{
+    if (m_texture != NULL)
+    {
+        SDL_DestroyTexture(m_texture);
+        m_texture = NULL;
+    }
+}
+
+void Fluid3D::SetMaxProjection(bool _maxProjection)
+{
+    m_maxProjection = _maxProjection;
+}
+
+bool Fluid3D::GetMaxProjection()
+{
+    return m_maxProjection;
+}
+
+void Fluid3D::SetSlice(int _slice)
+{
+    m_slice = std::min(std::max(_slice, 0), m_gridDimensions - 1);
+}
+
+int Fluid3D::GetSlice()
+{
+    return m_slice;
+}
+
+int Fluid3D::GetGridIndex(int _xPos, int _yPos, int _zPos)
+{
+    return _xPos + m_gridDimensions * (_yPos + m_gridDimensions * _zPos);
+}
+
+int Fluid3D::GetClampedIndex(int _xPos, int _yPos, int _zPos)
+{
+    int last = m_gridDimensions - 1;
+    return GetGridIndex(std::min(std::max(_xPos, 0), last), std::min(std::max(_yPos, 0), last), std::min(std::max(_zPos, 0), last));
+}
+
+int Fluid3D::GetGridDimensions()
+{
+    return m_gridDimensions;
+}
+
+int Fluid3D::GetThreadCount()
+{
+    return m_threads.GetThreadCount();
+}
+
+const std::vector<float>& Fluid3D::GetDensity()
+{
+    return m_density;
+}
@@ -0,0 +1,115 @@
+///
+/// @file FrameCodec.cpp
+/// @brief Lossless field compression for recordings (XOR delta, byte planes, run-length encoding)
+
+#include "FrameCodec.h"
+
+void FrameCodec::Encode(const uint32_t* _current, const uint32_t* _previous, size_t _count, std::vector<uint8_t>& _scratch, std::vector<uint8_t>& _out)
+{
+    // Delta against the previous frame, split into 4 byte planes
+    _scratch.resize(_count * 4);
+    uint8_t* planes = _scratch.data();
+    for (size_t i = 0; i < _count; ++i)
+    {
+        uint32_t word = _previous != NULL ? _current[i] ^ _previous[i] : _current[i];
+        planes[i] = uint8_t(word);
+        planes[i + _count] = uint8_t(word >> 8);
+        planes[i + _count * 2] = uint8_t(word >> 16);
+        planes[i + _count * 3] = uint8_t(word >> 24);
+    }
+    RunLengthEncode(planes, _scratch.size(), _out);
+}
+
+bool FrameCodec::Decode(const uint8_t* _data, size_t _size, const uint32_t* _previous, size_t _count, std::vector<uint8_t>& _scratch, uint32_t* _current)
+{
+    _scratch.resize(_count * 4);
+    if (!RunLengthDecode(_data, _size, _scratch.data(), _scratch.size()))
+    {
+        return false;
+    }
+
+    const uint8_t* planes = _scratch.data();
+    for (size_t i = 0; i < _count; ++i)
+    {
+        uint32_t word = uint32_t(planes[i]) |
+                        (uint32_t(planes[i + _count]) << 8) |
+                        (uint32_t(planes[i + _count * 2]) << 16) |
+                        (uint32_t(planes[i + _count * 3]) << 24);
+        _current[i] = _previous != NULL ? word ^ _previous[i] : word;
+    }
+    return true;
+}
+
+void FrameCodec::RunLengthEncode(const uint8_t* _data, size_t _size, std::vector<uint8_t>& _out)
+{
+    // PackBits style control byte:
+    //   0 - 127   : copy the next (n + 1) bytes literally
+    //   128 - 255 : repeat the next byte (n - 125) times, 3 to 130
+    size_t i = 0;
+    while (i < _size)
+    {
+        // Length of the run starting here
+        size_t run = 1;
+        while (i + run < _size && run < 130 && _data[i + run] == _data[i])
+        {
+            ++run;
+        }
+
+        if (run >= 3)
+        {
+            _out.push_back(uint8_t(run + 125));
+            _out.push_back(_data[i]);
+            i += run;
+            continue;
+        }
+
+        // Literal block, up to the next run of 3 or more
+        size_t start = i;
+        while (i < _size && i - start < 128)
+        {
+            if (i + 2 < _size && _data[i] == _data[i + 1] && _data[i] == _data[i + 2])
+            {
+                break;
+            }
+            ++i;
+        }
+        _out.push_back(uint8_t(i - start - 1));
+        _out.insert(_out.end(), _data + start, _data + i);
+    }
+}
+
+bool FrameCodec::RunLengthDecode(const uint8_t* _data, size_t _size, uint8_t* _out, size_t _outSize)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < _size)
+    {
+        uint8_t control = _data[in++];
+        if (control < 128)
+        {
+            size_t length = size_t(control) + 1;
+            if (in + length > _size || out + length > _outSize)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < length; ++i)
+            {
+                _out[out++] = _data[in++];
+            }
+        }
+        else
+        {
+            size_t length = size_t(control) - 125;
+            if (in >= _size || out + length > _outSize)
+            {
+                return false;
+            }
+            uint8_t value = _data[in++];
+            for (size_t i = 0; i < length; ++i)
+            {
+                _out[out++] = value;
+            }
+        }
+    }
+    return out == _outSize;
+}
@@ -0,0 +1,42 @@
+///
+/// @file GridLayout.cpp
+/// @brief Maps 2D grid coordinates onto linear field storage (row-major or 8x8 tiles)
+
+#include "GridLayout.h"
+
+GridLayout::GridLayout(MemoryLayout _layout, int _gridDimensions)
+{
+    m_layout = _layout;
+    m_gridDimensions = _gridDimensions;
+    // Partial tiles on the far edges are padded out to a full tile
+    m_tilesPerRow = (_gridDimensions + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+MemoryLayout GridLayout::GetLayout() const
+{
+    return m_layout;
+}
+
+int GridLayout::GetGridDimensions() const
+{
+    return m_gridDimensions;
+}
+
+int GridLayout::GetTilesPerRow() const
+{
+    return m_tilesPerRow;
+}
+
+int GridLayout::GetStorageSize() const
+{
+    if (m_layout == MemoryLayout::RowMajor)
+    {
+        return m_gridDimensions * m_gridDimensions;
+    }
+    return m_tilesPerRow * m_tilesPerRow * TILE_CELLS;
+}
+
+const char* GridLayout::GetName(MemoryLayout _layout)
+{
+    return _layout == MemoryLayout::RowMajor ? "row-major" : "tiled-8x8";
+}
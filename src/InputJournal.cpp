@@ -0,0 +1,379 @@
+///
+/// @file InputJournal.cpp
+/// @brief Records fluid inputs per frame to a binary log and feeds them back for reproducible runs
+
+#include "InputJournal.h"
+
+#include <cstring>
+#include <iostream>
+
+// Splats are journaled as raw structs
+static_assert(sizeof(Splat) == 7 * 4, "Splat must stay tightly packed");
+
+InputJournal::InputJournal()
+{
+    m_header = CreateHeader();
+}
+
+InputJournal::~InputJournal()
+{
+    Stop();
+}
+
+JournalHeader InputJournal::CreateHeader()
+{
+    JournalHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "FLUIDJNL", sizeof(header.magic));
+    header.byteOrder = 0x01020304;
+    header.version = m_VERSION;
+    return header;
+}
+
+bool InputJournal::StartRecording(std::string _path, const JournalHeader& _header, const std::vector<uint8_t>& _startupSnapshot)
+{
+    Stop();
+
+    m_file.open(_path, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        std::cout << "Unable to open input journal for writing: " << _path << "\n";
+        return false;
+    }
+
+    m_header = _header;
+    m_header.frameCount = 0;
+    m_header.eventCount = 0;
+    m_header.startupSnapshotLength = uint32_t(_startupSnapshot.size());
+    m_startupSnapshot = _startupSnapshot;
+
+    // Header is rewritten with the final counts by Stop
+    Write(m_header);
+    m_file.write(reinterpret_cast<const char*>(_startupSnapshot.data()), std::streamsize(_startupSnapshot.size()));
+    m_recording = true;
+    return true;
+}
+
+void InputJournal::Stop()
+{
+    if (!m_recording)
+    {
+        return;
+    }
+    m_recording = false;
+
+    m_file.seekp(0);
+    Write(m_header);
+    m_file.close();
+    std::cout << "Input journal: " << m_header.frameCount << " frames, " << m_header.eventCount << " events\n";
+}
+
+bool InputJournal::IsRecording()
+{
+    return m_recording;
+}
+
+void InputJournal::AddDensity(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, float _amount)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::Density);
+        Write(int32_t(_xPos));
+        Write(int32_t(_yPos));
+        Write(_amount);
+    }
+    _fluid.AddDensity(_xPos, _yPos, _amount);
+}
+
+void InputJournal::AddVelocity(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, float _amountX, float _amountY)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::Velocity);
+        Write(int32_t(_xPos));
+        Write(int32_t(_yPos));
+        Write(_amountX);
+        Write(_amountY);
+    }
+    _fluid.AddVelocity(_xPos, _yPos, _amountX, _amountY);
+}
+
+void InputJournal::ChangeResolution(Fluid& _fluid, uint32_t _frame, bool _scale)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::Resolution);
+        Write(uint8_t(_scale ? 1 : 0));
+    }
+    _fluid.ChangeResolution(_scale);
+}
+
+void InputJournal::Reset(Fluid& _fluid, uint32_t _frame)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::Reset);
+    }
+    _fluid.Reset();
+}
+
+void InputJournal::PaintObstacle(Fluid& _fluid, uint32_t _frame, int _xPos, int _yPos, int _radius, bool _solid)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::Obstacle);
+        Write(int32_t(_xPos));
+        Write(int32_t(_yPos));
+        Write(int32_t(_radius));
+        Write(uint8_t(_solid ? 1 : 0));
+    }
+    _fluid.PaintObstacle(_xPos, _yPos, _radius, _solid);
+}
+
+bool InputJournal::LoadObstacles(Fluid& _fluid, uint32_t _frame, std::string _path)
+{
+    if (!_fluid.LoadObstacles(_path))
+    {
+        return false;
+    }
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::ObstacleMask);
+        Write(uint32_t(_path.size()));
+        m_file.write(_path.data(), std::streamsize(_path.size()));
+    }
+    return true;
+}
+
+void InputJournal::SetSpeciesCount(Fluid& _fluid, uint32_t _frame, int _count)
+{
+    if (m_recording)
+    {
+        BeginEvent(_frame, JournalEvent::SpeciesCount);
+        Write(uint8_t(_count));
+    }
+    _fluid.SetSpeciesCount(_count);
+}
+
+void InputJournal::AddSplats(Fluid& _fluid, uint32_t _frame, const Splat* _splats, size_t _count)
+{
+    if (m_recording && _count > 0)
+    {
+        BeginEvent(_frame, JournalEvent::Splats);
+        Write(uint32_t(_count));
+        m_file.write(reinterpret_cast<const char*>(_splats), std::streamsize(_count * sizeof(Splat)));
+    }
+    _fluid.AddSplats(_splats, _count);
+}
+
+void InputJournal::EndFrame(uint32_t _frame)
+{
+    if (m_recording)
+    {
+        m_header.frameCount = _frame + 1;
+    }
+}
+
+bool InputJournal::Load(std::string _path)
+{
+    m_loaded = false;
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        std::cout << "Unable to open input journal: " << _path << "\n";
+        return false;
+    }
+
+    size_t size = size_t(file.tellg());
+    file.seekg(0);
+    if (size < sizeof(JournalHeader))
+    {
+        std::cout << "Input journal is truncated: " << _path << "\n";
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+    if (std::memcmp(m_header.magic, "FLUIDJNL", sizeof(m_header.magic)) != 0 || m_header.byteOrder != 0x01020304)
+    {
+        std::cout << "Not an input journal: " << _path << "\n";
+        return false;
+    }
+    if (m_header.version > m_VERSION || m_header.layout > uint32_t(MemoryLayout::Tiled) ||
+        m_header.startupSnapshotLength > size - sizeof(JournalHeader))
+    {
+        std::cout << "Unsupported input journal: " << _path << "\n";
+        return false;
+    }
+
+    if (m_header.version < 5 && m_header.startupSnapshotLength > 0)
+    {
+        std::cout << "Input journal version " << m_header.version << " only names its startup snapshot, which may have changed since. Record it again: " << _path << "\n";
+        return false;
+    }
+
+    m_startupSnapshot.resize(m_header.startupSnapshotLength);
+    file.read(reinterpret_cast<char*>(m_startupSnapshot.data()), std::streamsize(m_startupSnapshot.size()));
+
+    m_events.resize(size - sizeof(JournalHeader) - m_header.startupSnapshotLength);
+    file.read(reinterpret_cast<char*>(m_events.data()), std::streamsize(m_events.size()));
+    if (!file)
+    {
+        std::cout << "Unable to read input journal: " << _path << "\n";
+        return false;
+    }
+
+    m_readOffset = 0;
+    m_eventsRead = 0;
+    m_loaded = true;
+    return true;
+}
+
+bool InputJournal::IsLoaded()
+{
+    return m_loaded;
+}
+
+void InputJournal::Replay(Fluid& _fluid, uint32_t _frame)
+{
+    while (m_loaded && m_eventsRead < m_header.eventCount)
+    {
+        // Peek at the next event's frame
+        uint32_t frame;
+        size_t eventStart = m_readOffset;
+        if (!Read(frame) || frame > _frame)
+        {
+            m_readOffset = eventStart;
+            return;
+        }
+
+        uint8_t event = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        float a = 0;
+        float b = 0;
+        int32_t radius = 0;
+        uint8_t scale = 0;
+        uint32_t length = 0;
+        bool valid = Read(event);
+        switch (JournalEvent(event))
+        {
+            case JournalEvent::Density:
+                valid = valid && Read(x) && Read(y) && Read(a);
+                if (valid)
+                {
+                    _fluid.AddDensity(x, y, a);
+                }
+                break;
+            case JournalEvent::Velocity:
+                valid = valid && Read(x) && Read(y) && Read(a) && Read(b);
+                if (valid)
+                {
+                    _fluid.AddVelocity(x, y, a, b);
+                }
+                break;
+            case JournalEvent::Resolution:
+                valid = valid && Read(scale);
+                if (valid)
+                {
+                    _fluid.ChangeResolution(scale != 0);
+                }
+                break;
+            case JournalEvent::Reset:
+                if (valid)
+                {
+                    _fluid.Reset();
+                }
+                break;
+            case JournalEvent::Obstacle:
+                valid = valid && Read(x) && Read(y) && Read(radius) && Read(scale);
+                if (valid)
+                {
+                    _fluid.PaintObstacle(x, y, radius, scale != 0);
+                }
+                break;
+            case JournalEvent::ObstacleMask:
+                valid = valid && Read(length) && length <= m_events.size() - m_readOffset;
+                if (valid)
+                {
+                    std::string path(reinterpret_cast<const char*>(m_events.data() + m_readOffset), length);
+                    m_readOffset += length;
+                    if (!_fluid.LoadObstacles(path))
+                    {
+                        std::cout << "Replay will diverge, the obstacle mask is missing\n";
+                    }
+                }
+                break;
+            case JournalEvent::Species:
+                valid = valid && Read(x) && Read(y) && Read(scale) && Read(a);
+                if (valid)
+                {
+                    _fluid.AddSpecies(x, y, scale, a);
+                }
+                break;
+            case JournalEvent::Splats:
+                valid = valid && Read(length) && length <= (m_events.size() - m_readOffset) / sizeof(Splat);
+                if (valid)
+                {
+                    // Copied out, events aren't aligned in the journal
+                    m_splats.resize(length);
+                    std::memcpy(m_splats.data(), m_events.data() + m_readOffset, length * sizeof(Splat));
+                    m_readOffset += length * sizeof(Splat);
+                    _fluid.AddSplats(m_splats.data(), m_splats.size());
+                }
+                break;
+            case JournalEvent::SpeciesCount:
+                valid = valid && Read(scale);
+                if (valid)
+                {
+                    _fluid.SetSpeciesCount(scale);
+                }
+                break;
+            default:
+                valid = false;
+                break;
+        }
+
+        if (!valid)
+        {
+            std::cout << "Corrupt input journal event " << m_eventsRead << ", stopping replay\n";
+            m_loaded = false;
+            return;
+        }
+        m_eventsRead++;
+    }
+}
+
+const JournalHeader& InputJournal::GetHeader()
+{
+    return m_header;
+}
+
+const std::vector<uint8_t>& InputJournal::GetStartupSnapshot()
+{
+    return m_startupSnapshot;
+}
+
+template <typename T>
+void InputJournal::Write(const T& _value)
+{
+    m_file.write(reinterpret_cast<const char*>(&_value), sizeof(T));
+}
+
+void InputJournal::BeginEvent(uint32_t _frame, JournalEvent _event)
+{
+    Write(_frame);
+    Write(uint8_t(_event));
+    m_header.eventCount++;
+}
+
+template <typename T>
+bool InputJournal::Read(T& _value)
+{
+    if (m_readOffset + sizeof(T) > m_events.size())
+    {
+        return false;
+    }
+    std::memcpy(&_value, m_events.data() + m_readOffset, sizeof(T));
+    m_readOffset += sizeof(T);
+    return true;
+}
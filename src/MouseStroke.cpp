@@ -0,0 +1,107 @@
+///
+/// @file MouseStroke.cpp
+/// @brief Collects every mouse motion event in a frame and turns the path into Fluid splats
+
+#include "MouseStroke.h"
+
+#include <algorithm>
+#include <cmath>
+
+MouseStroke::MouseStroke()
+{
+    m_points.push_back({0.0f, 0.0f});
+}
+
+void MouseStroke::Begin(int _xPos, int _yPos)
+{
+    m_points.clear();
+    m_points.push_back({float(_xPos), float(_yPos)});
+    m_started = true;
+}
+
+void MouseStroke::AddPoint(int _xPos, int _yPos)
+{
+    Point point = {float(_xPos), float(_yPos)};
+    Point& last = m_points.back();
+    if (point.x == last.x && point.y == last.y)
+    {
+        return;
+    }
+
+    // Extend the last segment when the new point carries on in the same direction
+    if (m_points.size() >= 2)
+    {
+        const Point& start = m_points[m_points.size() - 2];
+        float dx = point.x - start.x;
+        float dy = point.y - start.y;
+        float ex = last.x - start.x;
+        float ey = last.y - start.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        float offset = std::fabs(dx * ey - dy * ex) / length;
+        if (offset <= m_TOLERANCE && dx * ex + dy * ey > 0.0f && dx * dx + dy * dy >= ex * ex + ey * ey)
+        {
+            last = point;
+            return;
+        }
+    }
+    m_points.push_back(point);
+}
+
+void MouseStroke::BuildSplats(std::vector<Splat>& _splats, float _radius, float _density, bool _velocity, int _species)
+{
+    float spacing = std::max(0.5f * _radius, 1.0f);
+    auto stepsFor = [&](const Point& _a, const Point& _b)
+    {
+        return std::max(1, int(std::ceil(std::hypot(_b.x - _a.x, _b.y - _a.y) / spacing)));
+    };
+
+    if (m_points.size() < 2)
+    {
+        const Point& point = m_points.back();
+        _splats.push_back({point.x, point.y, _radius, _density, 0.0f, 0.0f, _species});
+        m_started = false;
+        return;
+    }
+
+    // The start of the path was covered by the previous frame, unless the stroke only just began.
+    // In that case the first segment shares its displacement with a splat at the start point too.
+    bool splatStart = m_started;
+    m_started = false;
+    int splatCount = splatStart ? 1 : 0;
+    for (size_t n = 1; n < m_points.size(); ++n)
+    {
+        splatCount += stepsFor(m_points[n - 1], m_points[n]);
+    }
+    float density = _density / splatCount;
+
+    for (size_t n = 1; n < m_points.size(); ++n)
+    {
+        const Point& a = m_points[n - 1];
+        const Point& b = m_points[n];
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        int steps = stepsFor(a, b);
+        bool withStart = n == 1 && splatStart;
+        int shares = withStart ? steps + 1 : steps;
+        float xVel = _velocity ? dx / shares : 0.0f;
+        float yVel = _velocity ? dy / shares : 0.0f;
+
+        for (int step = withStart ? 0 : 1; step <= steps; ++step)
+        {
+            float t = float(step) / steps;
+            _splats.push_back({a.x + dx * t, a.y + dy * t, _radius, density, xVel, yVel, _species});
+        }
+    }
+}
+
+void MouseStroke::EndFrame()
+{
+    Point last = m_points.back();
+    m_points.clear();
+    m_points.push_back(last);
+}
+
+int MouseStroke::GetSegmentCount()
+{
+    return int(m_points.size()) - 1;
+}
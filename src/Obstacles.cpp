@@ -0,0 +1,204 @@
+///
+/// @file Obstacles.cpp
+/// @brief Solid obstacles inside the fluid, compiled into boundary cell lists for SetBounds
+
+#include <SDL_image.h>
+
+#include "Obstacles.h"
+#include "AdvectKernel.h"
+
+#include <algorithm>
+#include <iostream>
+
+Obstacles::Obstacles()
+{
+}
+
+bool Obstacles::LoadMask(std::string _path, int _screenDimensions)
+{
+    SDL_Surface* loadedSurface = IMG_Load(_path.c_str());
+    if (loadedSurface == NULL)
+    {
+        std::cout << "Unable to load obstacle mask! SDL_image Error: " << _path.c_str() << "\n" << IMG_GetError();
+        return false;
+    }
+
+    // Read pixels in a known format
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loadedSurface);
+    if (surface == NULL)
+    {
+        std::cout << "Unable to convert obstacle mask: " << _path.c_str() << "\nSDL Error: " << SDL_GetError();
+        return false;
+    }
+
+    // Opaque dark pixels are solid, the image is stretched over the screen
+    m_maskDimensions = _screenDimensions;
+    m_mask = std::vector<uint8_t>(_screenDimensions * _screenDimensions, 0);
+    SDL_LockSurface(surface);
+    const Uint8* pixels = static_cast<const Uint8*>(surface->pixels);
+    for (int y = 0; y < _screenDimensions; ++y)
+    {
+        const Uint8* row = pixels + (y * surface->h / _screenDimensions) * surface->pitch;
+        for (int x = 0; x < _screenDimensions; ++x)
+        {
+            const Uint8* pixel = row + (x * surface->w / _screenDimensions) * 4;
+            int luminance = (pixel[0] + pixel[1] + pixel[2]) / 3;
+            m_mask[x + y * _screenDimensions] = (pixel[3] >= 128 && luminance < 128) ? 1 : 0;
+        }
+    }
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    m_dirty = true;
+    return true;
+}
+
+void Obstacles::Paint(int _xPos, int _yPos, int _radius, bool _solid, int _screenDimensions)
+{
+    if (m_maskDimensions != _screenDimensions)
+    {
+        m_maskDimensions = _screenDimensions;
+        m_mask = std::vector<uint8_t>(_screenDimensions * _screenDimensions, 0);
+    }
+
+    // Filled circle
+    for (int y = std::max(_yPos - _radius, 0); y <= std::min(_yPos + _radius, _screenDimensions - 1); ++y)
+    {
+        for (int x = std::max(_xPos - _radius, 0); x <= std::min(_xPos + _radius, _screenDimensions - 1); ++x)
+        {
+            if ((x - _xPos) * (x - _xPos) + (y - _yPos) * (y - _yPos) <= _radius * _radius)
+            {
+                m_mask[x + y * _screenDimensions] = _solid ? 1 : 0;
+            }
+        }
+    }
+    m_dirty = true;
+}
+
+bool Obstacles::IsDirty()
+{
+    return m_dirty;
+}
+
+void Obstacles::Compile(const GridLayout& _layout, int _cellSize)
+{
+    m_dirty = false;
+    m_solidCells.clear();
+    m_solidPositions.clear();
+    for (BoundaryList& list : m_boundaries)
+    {
+        list.solid.clear();
+        list.fluid.clear();
+        list.weight.clear();
+    }
+    if (m_mask.empty())
+    {
+        return;
+    }
+
+    // Rasterise, the outer walls stay with Fluid::SetBounds so only interior cells can be solid
+    int gridDimensions = _layout.GetGridDimensions();
+    std::vector<uint8_t> solid(gridDimensions * gridDimensions, 0);
+    for (int j = 1; j < gridDimensions - 1; ++j)
+    {
+        for (int i = 1; i < gridDimensions - 1; ++i)
+        {
+            int x = std::min(i * _cellSize + _cellSize / 2, m_maskDimensions - 1);
+            int y = std::min(j * _cellSize + _cellSize / 2, m_maskDimensions - 1);
+            solid[i + j * gridDimensions] = m_mask[x + y * m_maskDimensions];
+        }
+    }
+
+    // Neighbour offsets in the order of m_boundaries (+x, -x, +y, -y)
+    const int dx[4] = {1, -1, 0, 0};
+    const int dy[4] = {0, 0, 1, -1};
+    // The ghost ring (0 and N - 1) is the outer wall, set by Fluid::SetBounds, so it never feeds a solid cell
+    auto isFluid = [&](int _i, int _j)
+    {
+        return _i > 0 && _i < gridDimensions - 1 && _j > 0 && _j < gridDimensions - 1 && !solid[_i + _j * gridDimensions];
+    };
+
+    for (int j = 1; j < gridDimensions - 1; ++j)
+    {
+        for (int i = 1; i < gridDimensions - 1; ++i)
+        {
+            if (!solid[i + j * gridDimensions])
+            {
+                continue;
+            }
+            int index = _layout.GetIndex(i, j);
+            m_solidCells.push_back(index);
+            m_solidPositions.push_back({i, j});
+
+            int fluidNeighbours = 0;
+            for (int d = 0; d < 4; ++d)
+            {
+                fluidNeighbours += isFluid(i + dx[d], j + dy[d]) ? 1 : 0;
+            }
+            for (int d = 0; d < 4; ++d)
+            {
+                if (isFluid(i + dx[d], j + dy[d]))
+                {
+                    m_boundaries[d].solid.push_back(index);
+                    m_boundaries[d].fluid.push_back(_layout.GetIndex(i + dx[d], j + dy[d]));
+                    m_boundaries[d].weight.push_back(1.0f / fluidNeighbours);
+                }
+            }
+        }
+    }
+}
+
+void Obstacles::Apply(int _b, std::vector<float>& _x)
+{
+    ApplyTo<1>(_b, _x.data());
+}
+
+void Obstacles::ApplyInterleaved(std::vector<float>& _x)
+{
+    ApplyTo<AdvectKernel::INTERLEAVED_WIDTH>(0, _x.data());
+}
+
+template <int Width>
+void Obstacles::ApplyTo(int _b, float* _x)
+{
+    // Cells fully inside an obstacle stay empty
+    for (int index : m_solidCells)
+    {
+        for (int n = 0; n < Width; ++n)
+        {
+            _x[index * Width + n] = 0.0f;
+        }
+    }
+
+    // Boundary cells average their fluid neighbours, negating the component that would flow into the wall
+    for (int d = 0; d < 4; ++d)
+    {
+        bool normal = d < 2 ? _b == 1 : _b == 2;
+        float sign = normal ? -1.0f : 1.0f;
+        const BoundaryList& list = m_boundaries[d];
+        const int* solid = list.solid.data();
+        const int* fluid = list.fluid.data();
+        const float* weight = list.weight.data();
+        int count = int(list.solid.size());
+        for (int k = 0; k < count; ++k)
+        {
+            float scale = sign * weight[k];
+            for (int n = 0; n < Width; ++n)
+            {
+                _x[solid[k] * Width + n] += scale * _x[fluid[k] * Width + n];
+            }
+        }
+    }
+}
+
+void Obstacles::Draw(SDL_Renderer* _renderer, int _cellSize)
+{
+    SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(_renderer, 0x60, 0x60, 0x60, 0xFF);
+    for (const SDL_Point& cell : m_solidPositions)
+    {
+        SDL_Rect rect = {cell.x * _cellSize, cell.y * _cellSize, _cellSize, _cellSize};
+        SDL_RenderFillRect(_renderer, &rect);
+    }
+}
@@ -0,0 +1,285 @@
+///
+/// @file Particles.cpp
+/// @brief Passive tracer particles carried by the fluid velocity
+
+#include "Particles.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+Particles::Particles(int _capacity, int _threads)
+    : m_threads(_threads)
+{
+    m_capacity = std::max(_capacity, 0);
+    m_x = std::vector<float>(m_capacity, 0.0f);
+    m_y = std::vector<float>(m_capacity, 0.0f);
+    m_life = std::vector<int>(m_capacity, 0);
+    m_freeList.reserve(m_capacity);
+    m_points = std::vector<SDL_FPoint>(m_capacity);
+
+    int chunks = (m_capacity + m_CHUNK_SIZE - 1) / m_CHUNK_SIZE;
+    m_chunkPoints = std::vector<int>(chunks, 0);
+    m_chunkRetired = std::vector<std::vector<int>>(chunks);
+}
+
+void Particles::Emit(int _xPos, int _yPos, int _count, float _radius, int _gridDimensions, float _cellSize)
+{
+    // New particles are placed on the current grid, so the old ones have to be on it too
+    Rescale(_gridDimensions);
+
+    for (int n = 0; n < _count; ++n)
+    {
+        int index;
+        if (!m_freeList.empty())
+        {
+            index = m_freeList.back();
+            m_freeList.pop_back();
+        }
+        else if (m_used < m_capacity)
+        {
+            index = m_used++;
+        }
+        else
+        {
+            // Pool is full
+            return;
+        }
+
+        // Uniform in a square around the cursor (LCG, so runs are repeatable)
+        m_seed = m_seed * 1664525u + 1013904223u;
+        float u = float(m_seed >> 8) / 16777216.0f - 0.5f;
+        m_seed = m_seed * 1664525u + 1013904223u;
+        float v = float(m_seed >> 8) / 16777216.0f - 0.5f;
+
+        // Screen pixels to grid cells (cell centres are at whole numbers, like AdvectKernel)
+        m_x[index] = (_xPos + 2.0f * _radius * u) / _cellSize - 0.5f;
+        m_y[index] = (_yPos + 2.0f * _radius * v) / _cellSize - 0.5f;
+        m_life[index] = m_LIFETIME;
+        m_alive++;
+    }
+}
+
+void Particles::Rescale(int _gridDimensions)
+{
+    if (m_gridDimensions != 0 && m_gridDimensions != _gridDimensions)
+    {
+        float scale = float(_gridDimensions) / m_gridDimensions;
+        for (int i = 0; i < m_used; ++i)
+        {
+            m_x[i] = (m_x[i] + 0.5f) * scale - 0.5f;
+            m_y[i] = (m_y[i] + 0.5f) * scale - 0.5f;
+        }
+    }
+    m_gridDimensions = _gridDimensions;
+}
+
+void Particles::Update(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, float _cellSize)
+{
+    int gridDimensions = _layout.GetGridDimensions();
+    Rescale(gridDimensions);
+
+    int chunks = (m_used + m_CHUNK_SIZE - 1) / m_CHUNK_SIZE;
+    float timeStep = _timeStep * (gridDimensions - 2);
+
+    m_threads.ParallelFor(0, chunks, [&](int _begin, int _end)
+    {
+        for (int chunk = _begin; chunk < _end; ++chunk)
+        {
+            int begin = chunk * m_CHUNK_SIZE;
+            int end = std::min(begin + m_CHUNK_SIZE, m_used);
+
+            // Free slots are moved too (they sit clamped inside the grid), which keeps the kernel branch free
+            Advance(_layout, _xVel, _yVel, timeStep, begin, end);
+
+            // Age, and write live particles to this chunk's part of the point list
+            std::vector<int>& retired = m_chunkRetired[chunk];
+            retired.clear();
+            int points = 0;
+            for (int i = begin; i < end; ++i)
+            {
+                if (m_life[i] == 0)
+                {
+                    continue;
+                }
+                if (--m_life[i] == 0)
+                {
+                    retired.push_back(i);
+                    continue;
+                }
+                m_points[begin + points].x = (m_x[i] + 0.5f) * _cellSize;
+                m_points[begin + points].y = (m_y[i] + 0.5f) * _cellSize;
+                points++;
+            }
+            m_chunkPoints[chunk] = points;
+        }
+    });
+
+    // Pack the chunks into one list and recycle expired slots
+    m_pointCount = 0;
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        int begin = chunk * m_CHUNK_SIZE;
+        if (m_pointCount != begin)
+        {
+            std::copy(m_points.begin() + begin, m_points.begin() + begin + m_chunkPoints[chunk], m_points.begin() + m_pointCount);
+        }
+        m_pointCount += m_chunkPoints[chunk];
+        m_freeList.insert(m_freeList.end(), m_chunkRetired[chunk].begin(), m_chunkRetired[chunk].end());
+        m_alive -= int(m_chunkRetired[chunk].size());
+    }
+}
+
+void Particles::Draw(SDL_Renderer* _renderer)
+{
+    if (m_pointCount == 0)
+    {
+        return;
+    }
+    SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_ADD);
+    SDL_SetRenderDrawColor(_renderer, 0x40, 0x90, 0xFF, 0x80);
+    SDL_RenderDrawPointsF(_renderer, m_points.data(), m_pointCount);
+}
+
+void Particles::Clear()
+{
+    std::fill(m_life.begin(), m_life.end(), 0);
+    m_freeList.clear();
+    m_used = 0;
+    m_alive = 0;
+    m_pointCount = 0;
+}
+
+int Particles::GetCount()
+{
+    return m_alive;
+}
+
+int Particles::GetCapacity()
+{
+    return m_capacity;
+}
+
+void Particles::Advance(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, int _begin, int _end)
+{
+    int i = _begin;
+
+#ifdef __AVX2__
+    int gridDimensions = _layout.GetGridDimensions();
+    const __m256 halfStep = _mm256_set1_ps(0.5f * _timeStep);
+    const __m256 step = _mm256_set1_ps(_timeStep);
+    const __m256 lower = _mm256_set1_ps(0.5f);
+    const __m256 upper = _mm256_set1_ps(gridDimensions - 1.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i oneInt = _mm256_set1_epi32(1);
+    const __m256i rowStride = _mm256_set1_epi32(gridDimensions);
+    const __m256i tilesPerRow = _mm256_set1_epi32(_layout.GetTilesPerRow());
+    const __m256i tileMask = _mm256_set1_epi32(GridLayout::TILE_MASK);
+    const bool tiled = _layout.GetLayout() == MemoryLayout::Tiled;
+
+    // Storage index of (x, y) for all 8 lanes, matching GridLayout::GetIndex
+    auto indexOf = [&](__m256i _x, __m256i _y)
+    {
+        if (!tiled)
+        {
+            return _mm256_add_epi32(_x, _mm256_mullo_epi32(_y, rowStride));
+        }
+        __m256i tile = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(_y, GridLayout::TILE_SHIFT), tilesPerRow),
+                                        _mm256_srli_epi32(_x, GridLayout::TILE_SHIFT));
+        __m256i local = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_y, tileMask), GridLayout::TILE_SHIFT),
+                                        _mm256_and_si256(_x, tileMask));
+        return _mm256_or_si256(_mm256_slli_epi32(tile, 2 * GridLayout::TILE_SHIFT), local);
+    };
+
+    // Bilinear velocity at 8 positions, which are already clamped so every tap is inside the grid
+    auto sample = [&](__m256 _x, __m256 _y, __m256& _u, __m256& _v)
+    {
+        __m256 xFloor = _mm256_floor_ps(_x);
+        __m256 yFloor = _mm256_floor_ps(_y);
+        __m256 s1 = _mm256_sub_ps(_x, xFloor);
+        __m256 t1 = _mm256_sub_ps(_y, yFloor);
+        __m256 s0 = _mm256_sub_ps(one, s1);
+        __m256 t0 = _mm256_sub_ps(one, t1);
+
+        __m256i i0 = _mm256_cvttps_epi32(xFloor);
+        __m256i j0 = _mm256_cvttps_epi32(yFloor);
+        __m256i i1 = _mm256_add_epi32(i0, oneInt);
+        __m256i j1 = _mm256_add_epi32(j0, oneInt);
+        __m256i index00 = indexOf(i0, j0);
+        __m256i index01 = indexOf(i0, j1);
+        __m256i index10 = indexOf(i1, j0);
+        __m256i index11 = indexOf(i1, j1);
+
+        auto blend = [&](const float* _field)
+        {
+            __m256 left = _mm256_fmadd_ps(t1, _mm256_i32gather_ps(_field, index01, 4), _mm256_mul_ps(t0, _mm256_i32gather_ps(_field, index00, 4)));
+            __m256 right = _mm256_fmadd_ps(t1, _mm256_i32gather_ps(_field, index11, 4), _mm256_mul_ps(t0, _mm256_i32gather_ps(_field, index10, 4)));
+            return _mm256_fmadd_ps(s1, right, _mm256_mul_ps(s0, left));
+        };
+        _u = blend(_xVel);
+        _v = blend(_yVel);
+    };
+
+    for (; i + 8 <= _end; i += 8)
+    {
+        __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&m_x[i]), lower), upper);
+        __m256 y = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&m_y[i]), lower), upper);
+        __m256 u;
+        __m256 v;
+
+        // Midpoint
+        sample(x, y, u, v);
+        __m256 xMid = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(halfStep, u, x), lower), upper);
+        __m256 yMid = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(halfStep, v, y), lower), upper);
+
+        // Full step with the midpoint velocity
+        sample(xMid, yMid, u, v);
+        _mm256_storeu_ps(&m_x[i], _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(step, u, x), lower), upper));
+        _mm256_storeu_ps(&m_y[i], _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(step, v, y), lower), upper));
+    }
+#endif
+
+    for (; i < _end; ++i)
+    {
+        AdvanceParticle(_layout, _xVel, _yVel, _timeStep, i);
+    }
+}
+
+void Particles::AdvanceParticle(const GridLayout& _layout, const float* _xVel, const float* _yVel, float _timeStep, int _index)
+{
+    float upper = _layout.GetGridDimensions() - 1.5f;
+    auto clamp = [&](float _value)
+    {
+        return std::min(std::max(_value, 0.5f), upper);
+    };
+    auto sample = [&](float _x, float _y, float& _u, float& _v)
+    {
+        int i0 = int(_x);
+        int j0 = int(_y);
+        float s1 = _x - i0;
+        float s0 = 1.0f - s1;
+        float t1 = _y - j0;
+        float t0 = 1.0f - t1;
+
+        int index00 = _layout.GetIndex(i0, j0);
+        int index01 = _layout.GetIndex(i0, j0 + 1);
+        int index10 = _layout.GetIndex(i0 + 1, j0);
+        int index11 = _layout.GetIndex(i0 + 1, j0 + 1);
+        _u = s0 * (t0 * _xVel[index00] + t1 * _xVel[index01]) + s1 * (t0 * _xVel[index10] + t1 * _xVel[index11]);
+        _v = s0 * (t0 * _yVel[index00] + t1 * _yVel[index01]) + s1 * (t0 * _yVel[index10] + t1 * _yVel[index11]);
+    };
+
+    float x = clamp(m_x[_index]);
+    float y = clamp(m_y[_index]);
+    float u;
+    float v;
+
+    // Midpoint, then the full step with the midpoint velocity
+    sample(x, y, u, v);
+    sample(clamp(x + 0.5f * _timeStep * u), clamp(y + 0.5f * _timeStep * v), u, v);
+    m_x[_index] = clamp(x + _timeStep * u);
+    m_y[_index] = clamp(y + _timeStep * v);
+}
@@ -0,0 +1,218 @@
+///
+/// @file Recorder.cpp
+/// @brief Captures fluid frames into a ring buffer and compresses them to disk on a background thread
+
+#include "Recorder.h"
+#include "FrameCodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+Recorder::Recorder()
+{
+}
+
+Recorder::~Recorder()
+{
+    Stop();
+}
+
+bool Recorder::Start(std::string _path, bool _includeVelocity, int _storageSize, int _ringFrames)
+{
+    Stop();
+
+    m_file.open(_path, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        std::cout << "Unable to open recording for writing: " << _path << "\n";
+        return false;
+    }
+
+    RecordingHeader header;
+    std::memcpy(header.magic, "FLUIDREC", sizeof(header.magic));
+    header.byteOrder = 0x01020304;
+    header.version = m_VERSION;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_ring = std::vector<Slot>(_ringFrames > 1 ? _ringFrames : 2);
+    m_head = 0;
+    m_tail = 0;
+    m_capturedFrames = 0;
+    m_droppedFrames = 0;
+    m_writtenBytes = sizeof(header);
+    m_includeVelocity = _includeVelocity;
+    AllocateSlots(_storageSize);
+    m_framesSinceKeyframe = 0;
+    std::memset(&m_previousHeader, 0, sizeof(m_previousHeader));
+    m_startTime = std::chrono::steady_clock::now();
+
+    m_running = true;
+    m_writer = std::thread(&Recorder::WriterThread, this);
+    return true;
+}
+
+void Recorder::Stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    // Writer drains whatever is still queued before exiting
+    m_running = false;
+    m_wake.notify_one();
+    m_writer.join();
+    m_file.close();
+
+    std::cout << "Recording stopped: " << m_capturedFrames << " frames captured, " << m_droppedFrames << " dropped, "
+              << m_writtenBytes / 1024 << " KiB written\n";
+}
+
+bool Recorder::IsRecording()
+{
+    return m_running;
+}
+
+void Recorder::Resize(int _storageSize)
+{
+    if (!m_running || _storageSize == m_slotSize)
+    {
+        return;
+    }
+
+    // Queued slots still hold frames of the old size, let the writer finish them first
+    while (m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed))
+    {
+        m_wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    AllocateSlots(_storageSize);
+}
+
+void Recorder::AllocateSlots(int _storageSize)
+{
+    m_slotSize = _storageSize;
+    for (Slot& slot : m_ring)
+    {
+        slot.fields[0].resize(size_t(_storageSize));
+        slot.fields[1].resize(m_includeVelocity ? size_t(_storageSize) : 0);
+        slot.fields[2].resize(m_includeVelocity ? size_t(_storageSize) : 0);
+    }
+}
+
+void Recorder::Capture(Fluid& _fluid, uint32_t _frameNumber)
+{
+    if (!m_running)
+    {
+        return;
+    }
+    if (int(_fluid.GetDensity().size()) != m_slotSize)
+    {
+        // Resize() wasn't called after a grid change, drop rather than allocate here
+        m_droppedFrames++;
+        return;
+    }
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail >= m_ring.size())
+    {
+        // Writer is behind, drop rather than stall the simulation
+        m_droppedFrames++;
+        return;
+    }
+
+    Slot& slot = m_ring[head % m_ring.size()];
+    RecordingFrameHeader& header = slot.header;
+    std::memset(&header, 0, sizeof(header));
+    header.frameNumber = _frameNumber;
+    header.timeMs = uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_startTime).count());
+    header.gridDimensions = uint32_t(_fluid.GetGridDimensions());
+    header.layout = uint32_t(_fluid.GetMemoryLayout());
+    header.storageSize = uint32_t(_fluid.GetDensity().size());
+    header.fieldCount = m_includeVelocity ? 3 : 1;
+
+    // Slots are already sized for this grid, so this only copies
+    std::copy(_fluid.GetDensity().begin(), _fluid.GetDensity().end(), slot.fields[0].begin());
+    if (m_includeVelocity)
+    {
+        std::copy(_fluid.GetXVelocity().begin(), _fluid.GetXVelocity().end(), slot.fields[1].begin());
+        std::copy(_fluid.GetYVelocity().begin(), _fluid.GetYVelocity().end(), slot.fields[2].begin());
+    }
+
+    m_head.store(head + 1, std::memory_order_release);
+    m_capturedFrames++;
+    m_wake.notify_one();
+}
+
+uint64_t Recorder::GetCapturedFrames()
+{
+    return m_capturedFrames;
+}
+
+uint64_t Recorder::GetDroppedFrames()
+{
+    return m_droppedFrames;
+}
+
+uint64_t Recorder::GetWrittenBytes()
+{
+    return m_writtenBytes;
+}
+
+void Recorder::WriterThread()
+{
+    while (true)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            if (!m_running)
+            {
+                break;
+            }
+            // The producer never takes this lock, so wake ups can be missed. The timeout covers that.
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+
+        WriteFrame(m_ring[tail % m_ring.size()]);
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+    m_file.flush();
+}
+
+void Recorder::WriteFrame(Slot& _slot)
+{
+    RecordingFrameHeader& header = _slot.header;
+
+    // Start a new delta chain periodically, and whenever the grid changes shape
+    bool keyframe = m_framesSinceKeyframe == 0 ||
+                    m_framesSinceKeyframe >= m_KEYFRAME_INTERVAL ||
+                    header.gridDimensions != m_previousHeader.gridDimensions ||
+                    header.layout != m_previousHeader.layout ||
+                    header.storageSize != m_previousHeader.storageSize ||
+                    header.fieldCount != m_previousHeader.fieldCount;
+    header.keyframe = keyframe ? 1 : 0;
+    m_framesSinceKeyframe = keyframe ? 1 : m_framesSinceKeyframe + 1;
+
+    m_encoded.clear();
+    for (uint32_t n = 0; n < header.fieldCount; ++n)
+    {
+        size_t start = m_encoded.size();
+        const uint32_t* current = reinterpret_cast<const uint32_t*>(_slot.fields[n].data());
+        FrameCodec::Encode(current, keyframe ? NULL : m_previous[n].data(), header.storageSize, m_scratch, m_encoded);
+        header.encodedSize[n] = uint32_t(m_encoded.size() - start);
+
+        m_previous[n].resize(header.storageSize);
+        std::memcpy(m_previous[n].data(), current, header.storageSize * sizeof(uint32_t));
+    }
+    m_previousHeader = header;
+
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(m_encoded.data()), std::streamsize(m_encoded.size()));
+    m_writtenBytes += sizeof(header) + m_encoded.size();
+}
@@ -0,0 +1,104 @@
+///
+/// @file RecordingReader.cpp
+/// @brief Reads back recordings written by Recorder, one decoded frame at a time
+
+#include "RecordingReader.h"
+#include "FrameCodec.h"
+
+#include <cstring>
+#include <iostream>
+
+RecordingReader::RecordingReader()
+{
+}
+
+bool RecordingReader::Open(std::string _path)
+{
+    m_file.close();
+    m_file.clear();
+    m_file.open(_path, std::ios::binary);
+    if (!m_file)
+    {
+        std::cout << "Unable to open recording: " << _path << "\n";
+        return false;
+    }
+
+    RecordingHeader header;
+    m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!m_file || std::memcmp(header.magic, "FLUIDREC", sizeof(header.magic)) != 0 || header.byteOrder != 0x01020304)
+    {
+        std::cout << "Not a fluid recording: " << _path << "\n";
+        return false;
+    }
+    if (header.version > Recorder::m_VERSION)
+    {
+        std::cout << "Unsupported recording version " << header.version << ": " << _path << "\n";
+        return false;
+    }
+
+    m_path = _path;
+    m_firstFrame = m_file.tellg();
+    m_haveFrame = false;
+    return true;
+}
+
+void RecordingReader::Rewind()
+{
+    m_file.clear();
+    m_file.seekg(m_firstFrame);
+    m_haveFrame = false;
+}
+
+bool RecordingReader::ReadFrame()
+{
+    RecordingFrameHeader header;
+    m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!m_file)
+    {
+        return false;
+    }
+    if (header.fieldCount < 1 || header.fieldCount > 3 || header.storageSize == 0)
+    {
+        std::cout << "Corrupt frame in recording: " << m_path << "\n";
+        return false;
+    }
+
+    // Deltas need a matching previous frame
+    bool keyframe = header.keyframe != 0;
+    if (!keyframe && (!m_haveFrame || header.storageSize != m_header.storageSize || header.fieldCount != m_header.fieldCount))
+    {
+        std::cout << "Recording delta frame has no matching keyframe: " << m_path << "\n";
+        return false;
+    }
+
+    for (uint32_t n = 0; n < header.fieldCount; ++n)
+    {
+        m_encoded.resize(header.encodedSize[n]);
+        m_file.read(reinterpret_cast<char*>(m_encoded.data()), std::streamsize(m_encoded.size()));
+
+        std::vector<float>& field = m_fields[n];
+        field.resize(header.storageSize);
+        // Decoding in place is safe, each word only depends on its own previous value
+        uint32_t* words = reinterpret_cast<uint32_t*>(field.data());
+        if (!m_file || !FrameCodec::Decode(m_encoded.data(), m_encoded.size(), keyframe ? NULL : words, header.storageSize, m_scratch, words))
+        {
+            std::cout << "Corrupt frame in recording: " << m_path << "\n";
+            m_haveFrame = false;
+            return false;
+        }
+    }
+
+    m_header = header;
+    m_haveFrame = true;
+    return true;
+}
+
+const RecordingFrameHeader& RecordingReader::GetFrameHeader()
+{
+    return m_header;
+}
+
+const std::vector<float>& RecordingReader::GetField(int _field)
+{
+    return m_fields[_field];
+}
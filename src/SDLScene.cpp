@@ -6,7 +6,13 @@
 
 #include "SDLScene.h"
 #include "Fluid.h"
+#include "Fluid3D.h"
+#include "Particles.h"
+#include "RecordingReader.h"
+#include "Snapshot.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 SDLScene::SDLScene()
@@ -64,12 +70,86 @@ void SDLScene::GameLoop()
 
     // Initialise mouse position
     SDL_GetMouseState(&m_mouseX, &m_mouseY);
+    m_stroke.Begin(m_mouseX, m_mouseY);
 
     // Event handler
 	SDL_Event e;
 
-    // Create fluid
-    Fluid fluid(m_SCREEN_SIZE, 0.1f, 0, 0, m_renderer);
+    // Create fluid (replays use the settings the journal was recorded with)
+    bool replaying = m_journal.IsLoaded();
+    float timeStep = m_TIME_STEP;
+    float diffusion = m_DIFFUSION;
+    float viscosity = m_VISCOSITY;
+    float fadeRate = m_FADE_RATE;
+    if (replaying)
+    {
+        const JournalHeader& header = m_journal.GetHeader();
+        m_layout = MemoryLayout(header.layout);
+        timeStep = header.timeStep;
+        diffusion = header.diffusion;
+        viscosity = header.viscosity;
+        fadeRate = header.fadeRate;
+    }
+    Fluid fluid(m_SCREEN_SIZE, timeStep, diffusion, viscosity, m_renderer, m_layout);
+
+    // Warm start from a checkpoint. A journal embeds the snapshot's contents, so they are read once and
+    // loaded from memory, and a replay starts from exactly the recorded state whatever happens to the file.
+    std::vector<uint8_t> startupSnapshot;
+    if (replaying)
+    {
+        startupSnapshot = m_journal.GetStartupSnapshot();
+        if (!startupSnapshot.empty() && !fluid.LoadSnapshot(startupSnapshot, "input journal"))
+        {
+            std::cout << "Starting from an empty fluid instead, the replay won't match\n";
+        }
+    }
+    else if (!m_startupSnapshot.empty())
+    {
+        bool loaded = m_journalPath.empty() ? fluid.LoadSnapshot(m_startupSnapshot) :
+                      Snapshot::ReadFile(m_startupSnapshot, startupSnapshot) && fluid.LoadSnapshot(startupSnapshot, m_startupSnapshot);
+        if (!loaded)
+        {
+            // Journaled as a cold start
+            startupSnapshot.clear();
+            std::cout << "Starting from an empty fluid instead\n";
+        }
+    }
+
+    // Journal every input from the first frame
+    if (!m_journalPath.empty())
+    {
+        JournalHeader header = InputJournal::CreateHeader();
+        header.screenDimensions = m_SCREEN_SIZE;
+        header.layout = uint32_t(m_layout);
+        header.timeStep = timeStep;
+        header.diffusion = diffusion;
+        header.viscosity = viscosity;
+        header.fadeRate = fadeRate;
+        if (m_journal.StartRecording(m_journalPath, header, startupSnapshot))
+        {
+            std::cout << "Recording input to: " << m_journalPath << "\n";
+        }
+    }
+
+    Particles particles(m_particleCapacity);
+
+    // Replays load the mask and species count from the journal
+    if (!m_obstaclePath.empty() && !replaying)
+    {
+        m_journal.LoadObstacles(fluid, m_frame, m_obstaclePath);
+    }
+    // A warm start may already have brought its species with it
+    if (m_speciesCount > 0 && m_speciesCount != fluid.GetSpeciesCount() && !replaying)
+    {
+        m_journal.SetSpeciesCount(fluid, m_frame, m_speciesCount);
+    }
+
+    if (!m_telemetryPath.empty())
+    {
+        m_telemetry.Start(m_telemetryPath, m_telemetryRate);
+    }
+    auto frameStart = std::chrono::steady_clock::now();
+    double frameMs = 0.0;
 
 	// While application is running
 	while (!quit)
@@ -81,8 +161,17 @@ void SDLScene::GameLoop()
 			{
 				quit = true;
 			}
+            if (e.type == SDL_MOUSEMOTION)
+            {
+                m_stroke.AddPoint(e.motion.x, e.motion.y);
+            }
             if (e.type == SDL_MOUSEBUTTONDOWN)
             {
+                // New stroke from the click
+                if (!m_LMBdown && !m_MMBdown && !m_RMBdown)
+                {
+                    m_stroke.Begin(e.button.x, e.button.y);
+                }
                 if (e.button.button == SDL_BUTTON_LEFT)
                 {
                     m_LMBdown = true;
@@ -137,17 +226,77 @@ void SDLScene::GameLoop()
                 m_showVelocity = false;
             }
         }
-        if (m_keyboard.GetKeyDown(SDL_SCANCODE_UP))
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_UP) && !replaying)
         {
-            fluid.ChangeResolution(true);
+            m_journal.ChangeResolution(fluid, m_frame, true);
         }
-        if (m_keyboard.GetKeyDown(SDL_SCANCODE_DOWN))
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_DOWN) && !replaying)
         {
-            fluid.ChangeResolution(false);
+            m_journal.ChangeResolution(fluid, m_frame, false);
         }
-        if (m_keyboard.GetKeyDown(SDL_SCANCODE_R))
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_R) && !replaying)
         {
-            fluid.Reset();
+            m_journal.Reset(fluid, m_frame);
+            particles.Clear();
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_F5))
+        {
+            if (m_journal.IsRecording())
+            {
+                std::cout << "Snapshots can't be saved while the input journal is recording\n";
+            }
+            else if (fluid.SaveSnapshot(m_snapshotPath))
+            {
+                std::cout << "Saved snapshot: " << m_snapshotPath << "\n";
+            }
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_F9))
+        {
+            if (m_journal.IsRecording() || replaying)
+            {
+                std::cout << "Snapshots can't be loaded while the input journal is in use\n";
+            }
+            else if (fluid.LoadSnapshot(m_snapshotPath))
+            {
+                std::cout << "Loaded snapshot: " << m_snapshotPath << "\n";
+                // The snapshot may bring fewer species
+                m_activeSpecies = std::min(m_activeSpecies, std::max(fluid.GetSpeciesCount() - 1, 0));
+            }
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_C))
+        {
+            if (!m_recorder.IsRecording())
+            {
+                if (m_recorder.Start(m_capturePath, m_captureVelocity, int(fluid.GetDensity().size())))
+                {
+                    std::cout << "Recording to: " << m_capturePath << "\n";
+                }
+            }
+            else
+            {
+                m_recorder.Stop();
+            }
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_O))
+        {
+            m_paintObstacles = !m_paintObstacles;
+            std::cout << (m_paintObstacles ? "Painting obstacles (LMB add, RMB erase)\n" : "Painting fluid\n");
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_P))
+        {
+            m_showParticles = !m_showParticles;
+            if (!m_showParticles)
+            {
+                particles.Clear();
+            }
+        }
+        const SDL_Scancode speciesKeys[] = {SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4};
+        for (int n = 0; n < fluid.GetSpeciesCount(); ++n)
+        {
+            if (m_keyboard.GetKeyDown(speciesKeys[n]))
+            {
+                m_activeSpecies = n;
+            }
         }
         if (m_keyboard.GetKeyDown(SDL_SCANCODE_ESCAPE))
         {
@@ -155,24 +304,46 @@ void SDLScene::GameLoop()
         }
 
         // Mouse button input
-        if (m_MMBdown)
+        float cellSize = float(m_SCREEN_SIZE) / fluid.GetGridDimensions();
+        if (replaying)
         {
-            UpdateMousePosition();
-            fluid.AddDensity(m_mouseX, m_mouseY, 255);
-            CalculateVelocity();
-            fluid.AddVelocity(m_mouseX, m_mouseY, m_xVel, m_yVel);
+            m_journal.Replay(fluid, m_frame);
+            if (m_frame >= m_journal.GetHeader().frameCount)
+            {
+                std::cout << "Replay finished: " << m_frame << " frames, state hash " << std::hex << fluid.GetStateHash() << std::dec << "\n";
+                quit = true;
+            }
         }
-        else if (m_LMBdown)
+        else if (m_paintObstacles)
         {
-            UpdateMousePosition();
-            fluid.AddDensity(m_mouseX, m_mouseY, 255);
+            if (m_LMBdown || m_RMBdown)
+            {
+                UpdateMousePosition();
+                m_journal.PaintObstacle(fluid, m_frame, m_mouseX, m_mouseY, m_OBSTACLE_RADIUS, m_LMBdown);
+            }
         }
-        else if (m_RMBdown)
+        else if (m_LMBdown || m_MMBdown || m_RMBdown)
         {
-            UpdateMousePosition();
-            CalculateVelocity();
-            fluid.AddVelocity(m_mouseX, m_mouseY, m_xVel, m_yVel);
+            // Every motion event since the last frame, as one batch (LMB: density, RMB: velocity, MMB: both)
+            bool density = m_LMBdown || m_MMBdown;
+            bool velocity = m_RMBdown || m_MMBdown;
+            m_splats.clear();
+            m_stroke.BuildSplats(m_splats, m_SPLAT_RADIUS * cellSize, density ? 255.0f : 0.0f, velocity,
+                                 density && fluid.GetSpeciesCount() > 0 ? m_activeSpecies : -1);
+            m_journal.AddSplats(fluid, m_frame, m_splats.data(), m_splats.size());
+
+            if (m_showParticles && density)
+            {
+                int count = std::max(1, m_PARTICLE_RATE / int(m_splats.size()));
+                for (const Splat& splat : m_splats)
+                {
+                    particles.Emit(int(splat.x), int(splat.y), count, 0.5f * cellSize, fluid.GetGridDimensions(), cellSize);
+                }
+            }
         }
+        m_stroke.EndFrame();
+        // Resolution keys, snapshot loads and replayed input can all change the grid
+        m_recorder.Resize(int(fluid.GetDensity().size()));
 
         // Clear screen
 		SDL_SetRenderDrawColor(m_renderer, 0x0, 0x0, 0x0, 0x0);
@@ -187,17 +358,266 @@ void SDLScene::GameLoop()
             fluid.ShowVelocity();
         }
 
+        bool publish = m_telemetry.IsDue();
+        fluid.SetStatsEnabled(publish);
         fluid.Update();
+        if (publish)
+        {
+            m_telemetry.Publish(m_frame, frameMs, fluid.GetStats());
+        }
         fluid.Draw();
-        fluid.Fade(0.01f);
+        if (m_showParticles)
+        {
+            particles.Update(fluid.GetGridLayout(), fluid.GetXVelocity().data(), fluid.GetYVelocity().data(), timeStep, cellSize);
+            particles.Draw(m_renderer);
+        }
+        fluid.Fade(fadeRate);
+        m_recorder.Capture(fluid, m_frame);
+        m_journal.EndFrame(m_frame);
+        m_frame++;
 
         // Update screen
 		SDL_RenderPresent(m_renderer);
+
+        // Whole frame including presentation, published with the next line
+        auto now = std::chrono::steady_clock::now();
+        frameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+        frameStart = now;
 	}
+    m_recorder.Stop();
+    m_journal.Stop();
+    m_telemetry.Stop();
+    fluid.Destroy();
+    Close();
+}
+
+void SDLScene::PlayRecording(std::string _path)
+{
+    RecordingReader reader;
+    if (!reader.Open(_path))
+    {
+        Close();
+        return;
+    }
+
+    bool quit = false;
+    bool paused = false;
+    SDL_Event e;
+
+    // Display only, the fluid is never stepped
+    Fluid fluid(m_SCREEN_SIZE, m_TIME_STEP, m_DIFFUSION, m_VISCOSITY, m_renderer, m_layout);
+    bool haveFrame = false;
+    Uint32 playbackStart = SDL_GetTicks();
+
+    while (!quit)
+    {
+        while (SDL_PollEvent(&e) != 0)
+        {
+            if (e.type == SDL_QUIT)
+            {
+                quit = true;
+            }
+        }
+
+        m_keyboard.Update();
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_G))
+        {
+            m_showGrid = !m_showGrid;
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_V))
+        {
+            m_showVelocity = !m_showVelocity;
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_SPACE))
+        {
+            paused = !paused;
+            // Resume from the current frame's timestamp
+            playbackStart = SDL_GetTicks() - (haveFrame ? reader.GetFrameHeader().timeMs : 0);
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_R))
+        {
+            reader.Rewind();
+            haveFrame = false;
+            playbackStart = SDL_GetTicks();
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_ESCAPE))
+        {
+            quit = true;
+        }
+
+        // Advance to the frame due at the current playback time, looping at the end
+        while (!paused && (!haveFrame || reader.GetFrameHeader().timeMs <= SDL_GetTicks() - playbackStart))
+        {
+            if (!reader.ReadFrame())
+            {
+                if (!haveFrame)
+                {
+                    // Nothing decodable at all
+                    quit = true;
+                    break;
+                }
+                // Loop, reading frame 0 straight away (the last frame's timestamp no longer applies)
+                reader.Rewind();
+                haveFrame = false;
+                playbackStart = SDL_GetTicks();
+            }
+            else
+            {
+                const RecordingFrameHeader& header = reader.GetFrameHeader();
+                bool velocity = header.fieldCount == 3;
+                fluid.SetState(int(header.gridDimensions), MemoryLayout(header.layout), reader.GetField(0),
+                               velocity ? &reader.GetField(1) : NULL, velocity ? &reader.GetField(2) : NULL);
+                haveFrame = true;
+            }
+        }
+
+        SDL_SetRenderDrawColor(m_renderer, 0x0, 0x0, 0x0, 0x0);
+        SDL_RenderClear(m_renderer);
+        if (m_showGrid)
+        {
+            fluid.ShowGrid();
+        }
+        if (m_showVelocity)
+        {
+            fluid.ShowVelocity();
+        }
+        fluid.Draw();
+        SDL_RenderPresent(m_renderer);
+    }
     fluid.Destroy();
     Close();
 }
 
+void SDLScene::VolumeLoop(int _gridDimensions)
+{
+    bool quit = false;
+    SDL_Event e;
+
+    SDL_GetMouseState(&m_mouseX, &m_mouseY);
+    Fluid3D fluid(_gridDimensions, m_TIME_STEP, m_DIFFUSION, m_VISCOSITY, m_renderer);
+    int cellSize = std::max(1, m_SCREEN_SIZE / _gridDimensions);
+
+    while (!quit)
+    {
+        while (SDL_PollEvent(&e) != 0)
+        {
+            if (e.type == SDL_QUIT)
+            {
+                quit = true;
+            }
+            if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP)
+            {
+                bool down = e.type == SDL_MOUSEBUTTONDOWN;
+                if (e.button.button == SDL_BUTTON_LEFT)
+                {
+                    m_LMBdown = down;
+                }
+                if (e.button.button == SDL_BUTTON_MIDDLE)
+                {
+                    m_MMBdown = down;
+                }
+                if (e.button.button == SDL_BUTTON_RIGHT)
+                {
+                    m_RMBdown = down;
+                }
+            }
+        }
+
+        m_keyboard.Update();
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_M))
+        {
+            fluid.SetMaxProjection(!fluid.GetMaxProjection());
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_UP))
+        {
+            fluid.SetSlice(fluid.GetSlice() + 1);
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_DOWN))
+        {
+            fluid.SetSlice(fluid.GetSlice() - 1);
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_R))
+        {
+            fluid.Reset();
+        }
+        if (m_keyboard.GetKeyDown(SDL_SCANCODE_ESCAPE))
+        {
+            quit = true;
+        }
+
+        // Mouse input goes into the viewed slice
+        if (m_LMBdown || m_MMBdown || m_RMBdown)
+        {
+            UpdateMousePosition();
+            CalculateVelocity();
+            int x = m_mouseX / cellSize;
+            int y = m_mouseY / cellSize;
+            if (m_LMBdown || m_MMBdown)
+            {
+                fluid.AddDensity(x, y, fluid.GetSlice(), 255);
+            }
+            if (m_RMBdown || m_MMBdown)
+            {
+                fluid.AddVelocity(x, y, fluid.GetSlice(), m_xVel, m_yVel, 0);
+            }
+        }
+
+        fluid.Update();
+        fluid.Fade(m_FADE_RATE);
+
+        SDL_SetRenderDrawColor(m_renderer, 0x0, 0x0, 0x0, 0x0);
+        SDL_RenderClear(m_renderer);
+        fluid.Draw();
+        SDL_RenderPresent(m_renderer);
+    }
+    fluid.Destroy();
+    Close();
+}
+
+bool SDLScene::ReplayInputHeadless()
+{
+    // Same frame sequence as GameLoop (input, Update, Fade) without a window
+    const JournalHeader& header = m_journal.GetHeader();
+    Fluid fluid(header.screenDimensions, header.timeStep, header.diffusion, header.viscosity, NULL, MemoryLayout(header.layout));
+    const std::vector<uint8_t>& snapshot = m_journal.GetStartupSnapshot();
+    if (!snapshot.empty() && !fluid.LoadSnapshot(snapshot, "input journal"))
+    {
+        return false;
+    }
+
+    if (!m_telemetryPath.empty())
+    {
+        m_telemetry.Start(m_telemetryPath, m_telemetryRate);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto frameStart = start;
+    double frameMs = 0.0;
+    for (uint32_t frame = 0; frame < header.frameCount; ++frame)
+    {
+        m_journal.Replay(fluid, frame);
+        bool publish = m_telemetry.IsDue();
+        fluid.SetStatsEnabled(publish);
+        fluid.Update();
+        if (publish)
+        {
+            m_telemetry.Publish(frame, frameMs, fluid.GetStats());
+        }
+        fluid.Fade(header.fadeRate);
+
+        auto now = std::chrono::steady_clock::now();
+        frameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+        frameStart = now;
+    }
+    m_telemetry.Stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Replay finished: " << header.frameCount << " frames, " << seconds * 1000.0 / std::max(1u, header.frameCount)
+              << " ms/frame, state hash " << std::hex << fluid.GetStateHash() << std::dec << "\n";
+    fluid.Destroy();
+    return true;
+}
+
 void SDLScene::Close()
 {
     // Destroy renderer
@@ -224,4 +644,50 @@ void SDLScene::CalculateVelocity()
 {
     m_xVel = float(m_mouseX - m_prevMouseX);
     m_yVel = float(m_mouseY - m_prevMouseY);
+}
+
+void SDLScene::SetMemoryLayout(MemoryLayout _layout)
+{
+    m_layout = _layout;
+}
+
+void SDLScene::SetStartupSnapshot(std::string _path)
+{
+    m_startupSnapshot = _path;
+}
+
+void SDLScene::SetCaptureVelocity(bool _captureVelocity)
+{
+    m_captureVelocity = _captureVelocity;
+}
+
+void SDLScene::SetInputRecording(std::string _path)
+{
+    m_journalPath = _path;
+}
+
+bool SDLScene::SetInputReplay(std::string _path)
+{
+    return m_journal.Load(_path);
+}
+
+void SDLScene::SetObstacles(std::string _path)
+{
+    m_obstaclePath = _path;
+}
+
+void SDLScene::SetParticleCapacity(int _capacity)
+{
+    m_particleCapacity = _capacity;
+}
+
+void SDLScene::SetSpeciesCount(int _count)
+{
+    m_speciesCount = _count;
+}
+
+void SDLScene::SetTelemetry(std::string _path, float _rate)
+{
+    m_telemetryPath = _path;
+    m_telemetryRate = _rate;
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+///
+/// @file Snapshot.cpp
+/// @brief Versioned binary snapshot of the solver state, memory-mapped for loading
+
+#include "Snapshot.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char SNAPSHOT_MAGIC[8] = {'F', 'L', 'U', 'I', 'D', 'S', 'N', 'P'};
+    const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+    uint64_t AlignUp(uint64_t _offset, uint64_t _alignment)
+    {
+        return (_offset + _alignment - 1) / _alignment * _alignment;
+    }
+}
+
+Snapshot::Snapshot()
+{
+}
+
+Snapshot::~Snapshot()
+{
+    Close();
+}
+
+SnapshotHeader Snapshot::CreateHeader()
+{
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.version = m_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    return header;
+}
+
+bool Snapshot::Save(std::string _path, const SnapshotHeader& _header, const float* const* _fields)
+{
+    if (_header.fieldCount > m_MAX_FIELDS)
+    {
+        std::cout << "Unable to save snapshot! Too many fields: " << _header.fieldCount << "\n";
+        return false;
+    }
+
+    // Lay out the field blocks after the header
+    SnapshotHeader header = _header;
+    uint64_t offset = AlignUp(sizeof(SnapshotHeader), m_BLOCK_ALIGNMENT);
+    for (uint32_t i = 0; i < header.fieldCount; ++i)
+    {
+        header.fieldOffsets[i] = offset;
+        offset += AlignUp(GetFieldSize(header, i) * sizeof(float), m_BLOCK_ALIGNMENT);
+    }
+
+    std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Unable to open snapshot for writing: " << _path << "\n";
+        return false;
+    }
+
+    std::vector<char> padding(m_BLOCK_ALIGNMENT, 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding.data(), std::streamsize(AlignUp(sizeof(header), m_BLOCK_ALIGNMENT) - sizeof(header)));
+    for (uint32_t i = 0; i < header.fieldCount; ++i)
+    {
+        uint64_t bytes = GetFieldSize(header, i) * sizeof(float);
+        file.write(reinterpret_cast<const char*>(_fields[i]), std::streamsize(bytes));
+        file.write(padding.data(), std::streamsize(AlignUp(bytes, m_BLOCK_ALIGNMENT) - bytes));
+    }
+
+    if (!file)
+    {
+        std::cout << "Unable to write snapshot: " << _path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::Open(std::string _path)
+{
+    Close();
+
+#ifdef _WIN32
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        std::cout << "Unable to open snapshot: " << _path << "\n";
+        return false;
+    }
+    m_size = size_t(file.tellg());
+    m_buffer = new unsigned char[m_size];
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_buffer), std::streamsize(m_size));
+    m_data = m_buffer;
+#else
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cout << "Unable to open snapshot: " << _path << "\n";
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        std::cout << "Unable to read snapshot: " << _path << "\n";
+        close(fd);
+        return false;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    // The whole file is about to be read, fault it in up front
+    flags |= MAP_POPULATE;
+#endif
+    void* mapping = mmap(NULL, size_t(info.st_size), PROT_READ, flags, fd, 0);
+    // The mapping keeps the file referenced, the descriptor is no longer needed
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cout << "Unable to map snapshot: " << _path << "\n";
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(mapping);
+    m_size = size_t(info.st_size);
+#endif
+
+    if (!Validate(_path))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::Open(const unsigned char* _data, size_t _size, std::string _name)
+{
+    Close();
+
+    m_data = _data;
+    m_size = _size;
+    m_borrowed = true;
+    if (!Validate(_name))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void Snapshot::Close()
+{
+#ifdef _WIN32
+    delete[] m_buffer;
+    m_buffer = NULL;
+#else
+    if (m_data != NULL && !m_borrowed)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+    m_data = NULL;
+    m_size = 0;
+    m_borrowed = false;
+}
+
+bool Snapshot::ReadFile(std::string _path, std::vector<uint8_t>& _bytes)
+{
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        std::cout << "Unable to open snapshot: " << _path << "\n";
+        return false;
+    }
+    _bytes.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(_bytes.data()), std::streamsize(_bytes.size()));
+    if (!file)
+    {
+        std::cout << "Unable to read snapshot: " << _path << "\n";
+        return false;
+    }
+    return true;
+}
+
+uint64_t Snapshot::GetFieldSize(const SnapshotHeader& _header, uint32_t _field)
+{
+    if (_field == uint32_t(SnapshotField::Species) || _field == uint32_t(SnapshotField::PrevSpecies))
+    {
+        return uint64_t(_header.storageSize) * _header.speciesWidth;
+    }
+    return _header.storageSize;
+}
+
+size_t Snapshot::GetSize()
+{
+    return m_size;
+}
+
+const SnapshotHeader* Snapshot::GetHeader()
+{
+    return reinterpret_cast<const SnapshotHeader*>(m_data);
+}
+
+const float* Snapshot::GetField(SnapshotField _field)
+{
+    uint32_t field = uint32_t(_field);
+    if (m_data == NULL || field >= GetHeader()->fieldCount)
+    {
+        return NULL;
+    }
+    return reinterpret_cast<const float*>(m_data + GetHeader()->fieldOffsets[field]);
+}
+
+bool Snapshot::Validate(std::string _path)
+{
+    if (m_size < sizeof(SnapshotHeader))
+    {
+        std::cout << "Snapshot is truncated: " << _path << "\n";
+        return false;
+    }
+
+    const SnapshotHeader* header = GetHeader();
+    if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        std::cout << "Not a fluid snapshot: " << _path << "\n";
+        return false;
+    }
+    if (header->byteOrder != SNAPSHOT_BYTE_ORDER)
+    {
+        std::cout << "Snapshot was written with a different byte order: " << _path << "\n";
+        return false;
+    }
+    // Version 1 headers stop before speciesCount
+    uint32_t headerSize = header->version < 2 ? uint32_t(offsetof(SnapshotHeader, speciesCount)) : uint32_t(sizeof(SnapshotHeader));
+    if (header->version < 1 || header->version > m_VERSION || header->headerSize != headerSize || header->fieldCount > m_MAX_FIELDS)
+    {
+        std::cout << "Unsupported snapshot version " << header->version << ": " << _path << "\n";
+        return false;
+    }
+
+    // Every field block must lie inside the file and keep its alignment (compared without overflowing on crafted sizes)
+    for (uint32_t i = 0; i < header->fieldCount; ++i)
+    {
+        uint64_t offset = header->fieldOffsets[i];
+        uint64_t floats = GetFieldSize(*header, i);
+        if (offset % m_BLOCK_ALIGNMENT != 0 || offset > m_size || floats > (m_size - offset) / sizeof(float))
+        {
+            std::cout << "Snapshot is truncated: " << _path << "\n";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,215 @@
+///
+/// @file Telemetry.cpp
+/// @brief Streams solver statistics as newline-delimited JSON to clients of a Unix domain socket
+
+#include "Telemetry.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+// macOS has no MSG_NOSIGNAL, SO_NOSIGPIPE is set on each client instead
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+    const char* STAGE_NAMES[int(SolverStage::Count)] =
+    {
+        "velocity_diffuse",
+        "velocity_project",
+        "velocity_advect",
+        "velocity_reproject",
+        "density_diffuse",
+        "density_advect",
+        "species"
+    };
+
+    // JSON has no nan or inf, so a solver that has blown up reports null instead
+    void AppendNumber(std::string& _line, const char* _format, double _value)
+    {
+        if (!std::isfinite(_value))
+        {
+            _line += "null";
+            return;
+        }
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), _format, _value);
+        _line += buffer;
+    }
+}
+
+Telemetry::Telemetry()
+{
+    m_interval = std::chrono::steady_clock::duration::zero();
+}
+
+Telemetry::~Telemetry()
+{
+    Stop();
+}
+
+bool Telemetry::Start(std::string _path, float _rate)
+{
+    Stop();
+
+#ifdef _WIN32
+    std::cout << "Telemetry is not supported on this platform\n";
+    return false;
+#else
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (_path.empty() || _path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "Invalid telemetry socket path: " << _path << "\n";
+        return false;
+    }
+    std::strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0)
+    {
+        std::cout << "Failed to create telemetry socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // A socket file left behind by a previous run would make bind fail
+    unlink(_path.c_str());
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(m_socket, 8) != 0)
+    {
+        std::cout << "Failed to listen on " << _path << ": " << std::strerror(errno) << "\n";
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK);
+
+    m_path = _path;
+    float rate = _rate > 0.0f ? _rate : m_DEFAULT_RATE;
+    m_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    m_nextPublish = std::chrono::steady_clock::now();
+    std::cout << "Telemetry on: " << m_path << " (" << rate << " Hz)\n";
+    return true;
+#endif
+}
+
+void Telemetry::Stop()
+{
+#ifndef _WIN32
+    for (int client : m_clients)
+    {
+        close(client);
+    }
+    m_clients.clear();
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        m_socket = -1;
+        unlink(m_path.c_str());
+    }
+#endif
+}
+
+bool Telemetry::IsRunning()
+{
+    return m_socket >= 0;
+}
+
+bool Telemetry::IsDue()
+{
+    if (m_socket < 0)
+    {
+        return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_nextPublish)
+    {
+        return false;
+    }
+    m_nextPublish = now + m_interval;
+
+    AcceptClients();
+    return !m_clients.empty();
+}
+
+void Telemetry::Publish(uint32_t _frame, double _frameMs, const FluidStats& _stats)
+{
+#ifndef _WIN32
+    char buffer[128];
+    m_line.clear();
+    std::snprintf(buffer, sizeof(buffer), "{\"frame\":%u,\"frame_ms\":", _frame);
+    m_line += buffer;
+    AppendNumber(m_line, "%.3f", _frameMs);
+    std::snprintf(buffer, sizeof(buffer), ",\"grid\":%d,\"iterations\":%d,\"stages_ms\":{", _stats.gridDimensions, _stats.iterations);
+    m_line += buffer;
+    for (int stage = 0; stage < int(SolverStage::Count); ++stage)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s\"%s\":", stage > 0 ? "," : "", STAGE_NAMES[stage]);
+        m_line += buffer;
+        AppendNumber(m_line, "%.3f", _stats.stageMs[stage]);
+    }
+    m_line += "},\"pressure_residual\":";
+    AppendNumber(m_line, "%g", _stats.pressureResidual);
+    m_line += ",\"total_density\":";
+    AppendNumber(m_line, "%.1f", _stats.totalDensity);
+    m_line += ",\"max_velocity\":";
+    AppendNumber(m_line, "%g", _stats.maxVelocity);
+    m_line += ",\"divergence\":";
+    AppendNumber(m_line, "%g", _stats.divergence);
+    m_line += "}\n";
+
+    for (size_t n = 0; n < m_clients.size();)
+    {
+        ssize_t sent = send(m_clients[n], m_line.data(), m_line.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        bool full = sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+
+        // A line that only partly fit would corrupt the stream, so drop a client that falls that far behind
+        if (sent == ssize_t(m_line.size()) || full)
+        {
+            ++n;
+            continue;
+        }
+        close(m_clients[n]);
+        m_clients.erase(m_clients.begin() + n);
+    }
+#else
+    (void)_frame;
+    (void)_frameMs;
+    (void)_stats;
+#endif
+}
+
+int Telemetry::GetClientCount()
+{
+    return int(m_clients.size());
+}
+
+void Telemetry::AcceptClients()
+{
+#ifndef _WIN32
+    while (true)
+    {
+        int client = accept(m_socket, NULL, NULL);
+        if (client < 0)
+        {
+            return;
+        }
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        m_clients.push_back(client);
+    }
+#endif
+}
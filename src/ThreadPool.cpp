@@ -0,0 +1,107 @@
+///
+/// @file ThreadPool.cpp
+/// @brief Persistent worker threads for splitting solver loops across cores
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int _threads)
+{
+    int threads = _threads > 0 ? _threads : int(std::thread::hardware_concurrency());
+    // The calling thread takes a share of every job, so it counts as one of the threads
+    for (int i = 1; i < threads; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::Worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(int _begin, int _end, const std::function<void(int, int)>& _func)
+{
+    if (_end <= _begin)
+    {
+        return;
+    }
+
+    // Small jobs, or no workers, run inline
+    int threads = GetThreadCount();
+    if (threads == 1 || _end - _begin == 1)
+    {
+        _func(_begin, _end);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &_func;
+        m_end = _end;
+        // A few chunks per thread evens out imbalance without too much claiming
+        m_chunkSize = std::max(1, (_end - _begin + threads * 4 - 1) / (threads * 4));
+        m_next = _begin;
+        m_busyWorkers = int(m_threads.size());
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_job = NULL;
+}
+
+int ThreadPool::GetThreadCount()
+{
+    return int(m_threads.size()) + 1;
+}
+
+void ThreadPool::Worker()
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_quit || m_generation != generation; });
+            if (m_quit)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        RunChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busyWorkers--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::RunChunks()
+{
+    while (true)
+    {
+        int begin = m_next.fetch_add(m_chunkSize);
+        if (begin >= m_end)
+        {
+            return;
+        }
+        (*m_job)(begin, std::min(begin + m_chunkSize, m_end));
+    }
+}
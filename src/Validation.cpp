@@ -0,0 +1,586 @@
+///
+/// @file Validation.cpp
+/// @brief Headless check of the optimised solver kernels against the frozen ReferenceSolver
+
+#include "Validation.h"
+#include "AdvectKernel.h"
+#include "Fluid.h"
+#include "Fluid3D.h"
+#include "ReferenceSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+namespace
+{
+    const float PI = 3.14159265f;
+
+    // Fluid derives its grid from screen size / cell size (32 pixels at the default resolution)
+    const int CELL_SIZE = 32;
+
+    // Best time in ms over _repeats runs of _kernel, each after an untimed _setup.
+    // The last run's output is left in place for comparison.
+    template <typename Setup, typename Kernel>
+    double TimeBest(int _repeats, Setup _setup, Kernel _kernel)
+    {
+        double best = 0.0;
+        for (int n = 0; n < _repeats; ++n)
+        {
+            _setup();
+            auto start = std::chrono::steady_clock::now();
+            _kernel();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = n == 0 ? ms : std::min(best, ms);
+        }
+        return best;
+    }
+
+    std::vector<float> Interleave(const GridLayout& _grid, const std::vector<float>* _fields, int _count)
+    {
+        int gridDimensions = _grid.GetGridDimensions();
+        std::vector<float> interleaved(_grid.GetStorageSize() * _count, 0.0f);
+        for (int j = 0; j < gridDimensions; ++j)
+        {
+            for (int i = 0; i < gridDimensions; ++i)
+            {
+                for (int n = 0; n < _count; ++n)
+                {
+                    interleaved[_grid.GetIndex(i, j) * _count + n] = _fields[n][i + j * gridDimensions];
+                }
+            }
+        }
+        return interleaved;
+    }
+
+    // Component _component of an interleaved field, row-major
+    std::vector<float> Extract(const GridLayout& _grid, const std::vector<float>& _interleaved, int _component, int _count)
+    {
+        int gridDimensions = _grid.GetGridDimensions();
+        std::vector<float> field(gridDimensions * gridDimensions);
+        for (int j = 0; j < gridDimensions; ++j)
+        {
+            for (int i = 0; i < gridDimensions; ++i)
+            {
+                field[i + j * gridDimensions] = _interleaved[_grid.GetIndex(i, j) * _count + _component];
+            }
+        }
+        return field;
+    }
+
+    std::string Format(const char* _format, ...)
+    {
+        char buffer[128];
+        va_list arguments;
+        va_start(arguments, _format);
+        std::vsnprintf(buffer, sizeof(buffer), _format, arguments);
+        va_end(arguments);
+        return buffer;
+    }
+}
+
+Validation::Validation(uint32_t _seed)
+{
+    m_seed = _seed;
+}
+
+bool Validation::Run()
+{
+    std::printf("Validating against the reference solver (seed %u, %s advection)\n", m_seed, AdvectKernel::IsVectorised() ? "AVX2" : "scalar");
+    std::printf("%-12s %-10s %5s %-9s %10s %10s %10s %9s %9s %8s  %s\n", "kernel", "backend", "N", "case", "max err", "L2 err", "tolerance", "ref ms", "ms", "speedup", "result");
+
+    for (int gridDimensions : m_gridSizes)
+    {
+        for (MemoryLayout layout : {MemoryLayout::RowMajor, MemoryLayout::Tiled})
+        {
+            CheckSetBounds(layout, gridDimensions);
+            CheckLinearSolve(layout, gridDimensions);
+            CheckProject(layout, gridDimensions);
+            CheckAdvect(layout, gridDimensions);
+            CheckFade(layout, gridDimensions);
+            CheckSpecies(layout, gridDimensions);
+            CheckStep(layout, gridDimensions);
+        }
+    }
+    CheckObstacles(MemoryLayout::RowMajor, 64);
+    CheckObstacles(MemoryLayout::Tiled, 64);
+    CheckVolume(32);
+    CheckVolume(64);
+
+    std::printf("%d checks, %d failed\n", m_checks, m_failures);
+    return m_failures == 0;
+}
+
+void Validation::CheckSetBounds(MemoryLayout _layout, int _gridDimensions)
+{
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    const GridLayout& grid = fluid.GetGridLayout();
+
+    const char* cases[] = {"b=0", "b=1", "b=2"};
+    for (int b = 0; b < 3; ++b)
+    {
+        std::vector<float> input = RandomField(_gridDimensions, -1.0f, 1.0f);
+        std::vector<float> expected;
+        std::vector<float> field;
+        double referenceMs = TimeBest(m_REPEATS, [&]{ expected = input; }, [&]{ reference.SetBounds(b, expected, _gridDimensions); });
+        double ms = TimeBest(m_REPEATS, [&]{ field = ToLayout(grid, input); }, [&]{ fluid.SetBounds(b, field, _gridDimensions); });
+
+        // Only copies and negations, so any difference is a bug
+        Report("SetBounds", GridLayout::GetName(_layout), _gridDimensions, cases[b], Compare(grid, field, expected), 0.0, referenceMs, ms);
+    }
+    fluid.Destroy();
+}
+
+void Validation::CheckLinearSolve(MemoryLayout _layout, int _gridDimensions)
+{
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    const GridLayout& grid = fluid.GetGridLayout();
+
+    // Diffusion for each boundary type, then the pressure solve's Poisson form
+    float a = m_TIME_STEP * m_DIFFUSION * (_gridDimensions - 2) * (_gridDimensions - 2);
+    struct Case
+    {
+        const char* name;
+        int b;
+        float a;
+        float c;
+    };
+    Case cases[] = {{"b=0", 0, a, 1 + 4 * a}, {"b=1", 1, a, 1 + 4 * a}, {"b=2", 2, a, 1 + 4 * a}, {"poisson", 0, 1.0f, 4.0f}};
+
+    for (const Case& test : cases)
+    {
+        std::vector<float> guess = RandomField(_gridDimensions, -1.0f, 1.0f);
+        std::vector<float> source = RandomField(_gridDimensions, -1.0f, 1.0f);
+        std::vector<float> layoutSource = ToLayout(grid, source);
+        std::vector<float> expected;
+        std::vector<float> field;
+        double referenceMs = TimeBest(m_REPEATS, [&]{ expected = guess; },
+                                      [&]{ reference.LinearSolve(test.b, expected, source, test.a, test.c, m_ITERATIONS, _gridDimensions); });
+        double ms = TimeBest(m_REPEATS, [&]{ field = ToLayout(grid, guess); },
+                             [&]{ fluid.LinearSolve(test.b, field, layoutSource, test.a, test.c, m_ITERATIONS, _gridDimensions); });
+
+        // Tiled sweeps still see updated left / up and old right / down neighbours, so only FMA contraction differs
+        Report("LinearSolve", GridLayout::GetName(_layout), _gridDimensions, test.name, Compare(grid, field, expected), 1.0e-5, referenceMs, ms);
+    }
+    fluid.Destroy();
+}
+
+void Validation::CheckProject(MemoryLayout _layout, int _gridDimensions)
+{
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    const GridLayout& grid = fluid.GetGridLayout();
+    GridLayout referenceGrid(MemoryLayout::RowMajor, _gridDimensions);
+
+    std::vector<float> xVel = RandomField(_gridDimensions, -1.0f, 1.0f);
+    std::vector<float> yVel = RandomField(_gridDimensions, -1.0f, 1.0f);
+    std::vector<float> scratch(_gridDimensions * _gridDimensions, 0.0f);
+
+    std::vector<float> expectedX;
+    std::vector<float> expectedY;
+    std::vector<float> p;
+    std::vector<float> div;
+    double referenceMs = TimeBest(m_REPEATS, [&]{ expectedX = xVel; expectedY = yVel; p = scratch; div = scratch; },
+                                  [&]{ reference.Project(expectedX, expectedY, p, div, m_ITERATIONS, _gridDimensions); });
+
+    std::vector<float> fieldX;
+    std::vector<float> fieldY;
+    double ms = TimeBest(m_REPEATS, [&]{ fieldX = ToLayout(grid, xVel); fieldY = ToLayout(grid, yVel); p = ToLayout(grid, scratch); div = p; },
+                         [&]{ fluid.Project(fieldX, fieldY, p, div, m_ITERATIONS, _gridDimensions); });
+
+    Error x = Compare(grid, fieldX, expectedX);
+    Error y = Compare(grid, fieldY, expectedY);
+    Error error = {std::max(x.max, y.max), std::max(x.l2, y.l2)};
+
+    // Four sweeps only remove part of the divergence, the optimised solve must remove as much as the reference
+    double before = Divergence(referenceGrid, xVel, yVel);
+    double referenceDivergence = Divergence(referenceGrid, expectedX, expectedY);
+    double divergence = Divergence(grid, fieldX, fieldY);
+    bool passed = divergence <= referenceDivergence * 1.01 + 1.0e-6;
+    std::string note = Format("div %.3g -> ref %.3g, opt %.3g", before, referenceDivergence, divergence);
+    Report("Project", GridLayout::GetName(_layout), _gridDimensions, "random", error, 1.0e-5, referenceMs, ms, note, passed);
+    fluid.Destroy();
+}
+
+void Validation::CheckAdvect(MemoryLayout _layout, int _gridDimensions)
+{
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    const GridLayout& grid = fluid.GetGridLayout();
+
+    // Backtraces of up to 4 cells, and some far enough to be clamped at the walls
+    float speed = 4.0f / (m_TIME_STEP * (_gridDimensions - 2));
+    std::vector<float> xVel = RandomField(_gridDimensions, -speed, speed);
+    std::vector<float> yVel = RandomField(_gridDimensions, -speed, speed);
+    for (int n = 0; n < _gridDimensions; ++n)
+    {
+        xVel[n * _gridDimensions + 1] = 10.0f * speed;
+        yVel[_gridDimensions + n] = 10.0f * speed;
+    }
+    std::vector<float> layoutXVel = ToLayout(grid, xVel);
+    std::vector<float> layoutYVel = ToLayout(grid, yVel);
+
+    double tolerance = AdvectTolerance(_gridDimensions);
+
+    const char* cases[] = {"b=0", "b=1", "b=2"};
+    for (int b = 0; b < 3; ++b)
+    {
+        std::vector<float> source = RandomField(_gridDimensions, -1.0f, 1.0f);
+        std::vector<float> layoutSource = ToLayout(grid, source);
+        std::vector<float> expected(source.size(), 0.0f);
+        std::vector<float> field(layoutSource.size(), 0.0f);
+        double referenceMs = TimeBest(m_REPEATS, []{}, [&]{ reference.Advect(b, expected, source, xVel, yVel, m_TIME_STEP, _gridDimensions); });
+        double ms = TimeBest(m_REPEATS, []{}, [&]{ fluid.Advect(b, field, layoutSource, layoutXVel, layoutYVel, m_TIME_STEP, _gridDimensions); });
+        Report("Advect", GridLayout::GetName(_layout), _gridDimensions, cases[b], Compare(grid, field, expected), tolerance, referenceMs, ms);
+    }
+
+    // Both velocity components through one shared backtrace, against two reference calls
+    std::vector<float> expectedX(xVel.size(), 0.0f);
+    std::vector<float> expectedY(yVel.size(), 0.0f);
+    std::vector<float> fieldX(layoutXVel.size(), 0.0f);
+    std::vector<float> fieldY(layoutYVel.size(), 0.0f);
+    double referenceMs = TimeBest(m_REPEATS, []{}, [&]
+    {
+        reference.Advect(1, expectedX, xVel, xVel, yVel, m_TIME_STEP, _gridDimensions);
+        reference.Advect(2, expectedY, yVel, xVel, yVel, m_TIME_STEP, _gridDimensions);
+    });
+    AdvectTarget targets[] = {{1, &fieldX, &layoutXVel}, {2, &fieldY, &layoutYVel}};
+    double ms = TimeBest(m_REPEATS, []{}, [&]{ fluid.AdvectFields(targets, 2, layoutXVel, layoutYVel, m_TIME_STEP, _gridDimensions); });
+
+    Error x = Compare(grid, fieldX, expectedX);
+    Error y = Compare(grid, fieldY, expectedY);
+    Report("AdvectFields", GridLayout::GetName(_layout), _gridDimensions, "velocity", {std::max(x.max, y.max), std::max(x.l2, y.l2)}, tolerance, referenceMs, ms);
+    fluid.Destroy();
+}
+
+void Validation::CheckFade(MemoryLayout _layout, int _gridDimensions)
+{
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    const GridLayout& grid = fluid.GetGridLayout();
+
+    // Either side of the clamps
+    std::vector<float> density = RandomField(_gridDimensions, -10.0f, 300.0f);
+    std::vector<float> layoutDensity = ToLayout(grid, density);
+    double referenceMs = TimeBest(m_REPEATS, [&]{ reference.SetState(density, NULL, NULL); }, [&]{ reference.Fade(0.5f); });
+    double ms = TimeBest(m_REPEATS, [&]{ fluid.SetState(_gridDimensions, _layout, layoutDensity, NULL, NULL); }, [&]{ fluid.Fade(0.5f); });
+    Report("Fade", GridLayout::GetName(_layout), _gridDimensions, "random", Compare(grid, fluid.GetDensity(), reference.GetDensity()), 0.0, referenceMs, ms);
+    fluid.Destroy();
+}
+
+void Validation::CheckSpecies(MemoryLayout _layout, int _gridDimensions)
+{
+    const int count = Fluid::m_MAX_SPECIES;
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, 0, 0, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, 0, 0);
+    fluid.SetSpeciesCount(count);
+    const GridLayout& grid = fluid.GetGridLayout();
+    GridLayout referenceGrid(MemoryLayout::RowMajor, _gridDimensions);
+
+    std::vector<float> guess[count];
+    std::vector<float> source[count];
+    for (int n = 0; n < count; ++n)
+    {
+        guess[n] = RandomField(_gridDimensions, 0.0f, 255.0f);
+        source[n] = RandomField(_gridDimensions, 0.0f, 255.0f);
+    }
+    float speed = 4.0f / (m_TIME_STEP * (_gridDimensions - 2));
+    std::vector<float> xVel = RandomField(_gridDimensions, -speed, speed);
+    std::vector<float> yVel = RandomField(_gridDimensions, -speed, speed);
+    std::vector<float> layoutXVel = ToLayout(grid, xVel);
+    std::vector<float> layoutYVel = ToLayout(grid, yVel);
+    std::vector<float> interleavedSource = Interleave(grid, source, count);
+
+    // Each species against its own reference field
+    auto compare = [&](const std::vector<float>& _field, const std::vector<float>* _expected)
+    {
+        Error error = {0.0, 0.0};
+        for (int n = 0; n < count; ++n)
+        {
+            Error species = Compare(referenceGrid, Extract(grid, _field, n, count), _expected[n]);
+            error.max = std::max(error.max, species.max);
+            error.l2 = std::max(error.l2, species.l2);
+        }
+        return error;
+    };
+
+    // Diffusion (one Gauss-Seidel sweep for every species)
+    std::vector<float> expected[count];
+    std::vector<float> field;
+    double referenceMs = TimeBest(m_REPEATS, [&]{ std::copy(guess, guess + count, expected); }, [&]
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            reference.Diffuse(0, expected[n], source[n], m_DIFFUSION, m_TIME_STEP, m_ITERATIONS, _gridDimensions);
+        }
+    });
+    double ms = TimeBest(m_REPEATS, [&]{ field = Interleave(grid, guess, count); },
+                         [&]{ fluid.DiffuseSpecies(field, interleavedSource, m_DIFFUSION, m_TIME_STEP, m_ITERATIONS, _gridDimensions); });
+    Report("Species", GridLayout::GetName(_layout), _gridDimensions, "diffuse", compare(field, expected), 1.0e-5, referenceMs, ms);
+
+    // Advection (one backtrace for every species)
+    referenceMs = TimeBest(m_REPEATS, []{}, [&]
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            reference.Advect(0, expected[n], source[n], xVel, yVel, m_TIME_STEP, _gridDimensions);
+        }
+    });
+    ms = TimeBest(m_REPEATS, []{}, [&]{ fluid.AdvectSpecies(field, interleavedSource, layoutXVel, layoutYVel, m_TIME_STEP, _gridDimensions); });
+    Report("Species", GridLayout::GetName(_layout), _gridDimensions, "advect", compare(field, expected), AdvectTolerance(_gridDimensions), referenceMs, ms);
+    fluid.Destroy();
+}
+
+void Validation::CheckStep(MemoryLayout _layout, int _gridDimensions)
+{
+    // Scripted: a density blob in a divergence-free vortex moving up to 2 cells a frame
+    std::vector<float> density(_gridDimensions * _gridDimensions);
+    std::vector<float> xVel(density.size());
+    std::vector<float> yVel(density.size());
+    float speed = 2.0f / (m_TIME_STEP * (_gridDimensions - 2));
+    float centre = 0.5f * _gridDimensions;
+    for (int j = 0; j < _gridDimensions; ++j)
+    {
+        for (int i = 0; i < _gridDimensions; ++i)
+        {
+            float x = PI * i / (_gridDimensions - 1);
+            float y = PI * j / (_gridDimensions - 1);
+            float dx = (i - 0.6f * centre) / (0.3f * centre);
+            float dy = (j - centre) / (0.3f * centre);
+            density[i + j * _gridDimensions] = 200.0f * std::exp(-(dx * dx + dy * dy));
+            xVel[i + j * _gridDimensions] = speed * std::sin(x) * std::cos(y);
+            yVel[i + j * _gridDimensions] = -speed * std::cos(x) * std::sin(y);
+        }
+    }
+
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, m_DIFFUSION, m_DIFFUSION, NULL, _layout);
+    ReferenceSolver reference(_gridDimensions, m_TIME_STEP, m_DIFFUSION, m_DIFFUSION);
+    const GridLayout& grid = fluid.GetGridLayout();
+    GridLayout referenceGrid(MemoryLayout::RowMajor, _gridDimensions);
+    std::vector<float> layoutXVel = ToLayout(grid, xVel);
+    std::vector<float> layoutYVel = ToLayout(grid, yVel);
+    reference.SetState(density, &xVel, &yVel);
+    fluid.SetState(_gridDimensions, _layout, ToLayout(grid, density), &layoutXVel, &layoutYVel);
+
+    // Whole frames, timed once (the state carries on from frame to frame)
+    double start = Total(referenceGrid, density);
+    double referenceMs = TimeBest(1, []{}, [&]
+    {
+        for (int frame = 0; frame < m_STEP_FRAMES; ++frame)
+        {
+            reference.Update();
+        }
+    }) / m_STEP_FRAMES;
+    double ms = TimeBest(1, []{}, [&]
+    {
+        for (int frame = 0; frame < m_STEP_FRAMES; ++frame)
+        {
+            fluid.Update();
+        }
+    }) / m_STEP_FRAMES;
+
+    Error d = Compare(grid, fluid.GetDensity(), reference.GetDensity());
+    Error x = Compare(grid, fluid.GetXVelocity(), reference.GetXVelocity());
+    Error y = Compare(grid, fluid.GetYVelocity(), reference.GetYVelocity());
+    Error error = {std::max(d.max, std::max(x.max, y.max)), std::max(d.l2, std::max(x.l2, y.l2))};
+
+    // Semi-Lagrangian advection isn't conservative, but the optimised step mustn't gain or lose more mass
+    double referenceDrift = Total(referenceGrid, reference.GetDensity()) / start - 1.0;
+    double drift = Total(grid, fluid.GetDensity()) / start - 1.0;
+    double referenceDivergence = Divergence(referenceGrid, reference.GetXVelocity(), reference.GetYVelocity());
+    double divergence = Divergence(grid, fluid.GetXVelocity(), fluid.GetYVelocity());
+    bool passed = std::fabs(drift - referenceDrift) <= 1.0e-4 && divergence <= referenceDivergence * 1.01 + 1.0e-6;
+    std::string note = Format("mass %+.2e / ref %+.2e, div %.3g / ref %.3g", drift, referenceDrift, divergence, referenceDivergence);
+
+    // Rounding differences compound over the frames
+    Report("Update", GridLayout::GetName(_layout), _gridDimensions, "vortex", error, 1.0e-4, referenceMs, ms, note, passed);
+    fluid.Destroy();
+}
+
+void Validation::CheckObstacles(MemoryLayout _layout, int _gridDimensions)
+{
+    // No reference handles obstacles, so check the invariant instead: nothing enters a solid
+    Fluid fluid(_gridDimensions * CELL_SIZE, m_TIME_STEP, m_DIFFUSION, m_DIFFUSION, NULL, _layout);
+    const GridLayout& grid = fluid.GetGridLayout();
+    std::vector<float> density = RandomField(_gridDimensions, 0.0f, 255.0f);
+    float speed = 2.0f / (m_TIME_STEP * (_gridDimensions - 2));
+    std::vector<float> xVel = ToLayout(grid, RandomField(_gridDimensions, -speed, speed));
+    std::vector<float> yVel = ToLayout(grid, RandomField(_gridDimensions, -speed, speed));
+    fluid.SetState(_gridDimensions, _layout, ToLayout(grid, density), &xVel, &yVel);
+
+    int centre = _gridDimensions * CELL_SIZE / 2;
+    int radius = _gridDimensions * CELL_SIZE / 8;
+    fluid.PaintObstacle(centre, centre, radius, true);
+    double ms = TimeBest(1, []{}, [&]
+    {
+        for (int frame = 0; frame < m_STEP_FRAMES; ++frame)
+        {
+            fluid.Update();
+        }
+    }) / m_STEP_FRAMES;
+
+    // Cells well inside the disc (away from rasterisation at its edge)
+    double largest = 0.0;
+    int solids = 0;
+    for (int j = 1; j < _gridDimensions - 1; ++j)
+    {
+        for (int i = 1; i < _gridDimensions - 1; ++i)
+        {
+            float dx = (i + 0.5f) * CELL_SIZE - centre;
+            float dy = (j + 0.5f) * CELL_SIZE - centre;
+            if (std::sqrt(dx * dx + dy * dy) < radius - CELL_SIZE)
+            {
+                int index = grid.GetIndex(i, j);
+                largest = std::max(largest, double(std::fabs(fluid.GetDensity()[index])));
+                largest = std::max(largest, double(std::fabs(fluid.GetXVelocity()[index])));
+                largest = std::max(largest, double(std::fabs(fluid.GetYVelocity()[index])));
+                solids++;
+            }
+        }
+    }
+
+    Report("Obstacles", GridLayout::GetName(_layout), _gridDimensions, "disc", {largest, 0.0}, 0.0, 0.0, ms,
+           Format("largest absolute value in %d solid cells", solids));
+    fluid.Destroy();
+}
+
+void Validation::CheckVolume(int _gridDimensions)
+{
+    // Red-black Gauss-Seidel and per-cell advection don't depend on how rows are split, so every
+    // thread count must give the single threaded result bit for bit
+    Fluid3D single(_gridDimensions, m_TIME_STEP, m_DIFFUSION, m_DIFFUSION, NULL, 1);
+    Fluid3D threaded(_gridDimensions, m_TIME_STEP, m_DIFFUSION, m_DIFFUSION, NULL, 4);
+
+    auto run = [&](Fluid3D& _fluid)
+    {
+        int centre = _gridDimensions / 2;
+        for (int frame = 0; frame < m_STEP_FRAMES; ++frame)
+        {
+            float angle = frame * 0.3f;
+            _fluid.AddDensity(centre, centre, centre, 255);
+            _fluid.AddVelocity(centre, centre, centre, std::cos(angle) * 50.0f, std::sin(angle) * 50.0f, 20.0f);
+            _fluid.Update();
+        }
+    };
+    double referenceMs = TimeBest(1, []{}, [&]{ run(single); }) / m_STEP_FRAMES;
+    double ms = TimeBest(1, []{}, [&]{ run(threaded); }) / m_STEP_FRAMES;
+
+    const std::vector<float>& expected = single.GetDensity();
+    const std::vector<float>& density = threaded.GetDensity();
+    double largest = 0.0;
+    double difference = 0.0;
+    double norm = 0.0;
+    for (size_t n = 0; n < expected.size(); ++n)
+    {
+        largest = std::max(largest, double(std::fabs(density[n] - expected[n])));
+        difference += double(density[n] - expected[n]) * (density[n] - expected[n]);
+        norm += double(expected[n]) * expected[n];
+    }
+    Error error = {largest, std::sqrt(difference / std::max(norm, 1.0e-30))};
+
+    Report("Fluid3D", "threaded", _gridDimensions, "jet", error, 0.0, referenceMs, ms, Format("%d threads against 1", threaded.GetThreadCount()));
+    single.Destroy();
+    threaded.Destroy();
+}
+
+void Validation::Report(const char* _kernel, const char* _backend, int _gridDimensions, const char* _case, Error _error,
+                        double _tolerance, double _referenceMs, double _ms, const std::string& _note, bool _passed)
+{
+    bool passed = _passed && _error.max <= _tolerance;
+    m_checks++;
+    m_failures += passed ? 0 : 1;
+
+    char speedup[16] = "n/a";
+    char referenceMs[16] = "n/a";
+    if (_referenceMs > 0.0 && _ms > 0.0)
+    {
+        std::snprintf(speedup, sizeof(speedup), "%.2fx", _referenceMs / _ms);
+        std::snprintf(referenceMs, sizeof(referenceMs), "%.3f", _referenceMs);
+    }
+    std::printf("%-12s %-10s %5d %-9s %10.2e %10.2e %10.1e %9s %9.3f %8s  %s%s%s\n", _kernel, _backend, _gridDimensions, _case,
+                _error.max, _error.l2, _tolerance, referenceMs, _ms, speedup, passed ? "ok" : "FAIL", _note.empty() ? "" : "  ", _note.c_str());
+    std::fflush(stdout);
+}
+
+double Validation::AdvectTolerance(int _gridDimensions)
+{
+    // The vector backtrace is one FMA where the reference may round twice (unless the compiler contracts it too).
+    // Positions are up to N cells, so that moves the sample by ~N ulps and random fields change by up to 2 per cell.
+    return 1.0e-5 + 2.0 * _gridDimensions * FLT_EPSILON;
+}
+
+std::vector<float> Validation::RandomField(int _gridDimensions, float _min, float _max)
+{
+    // LCG, so a seed always gives the same fields
+    std::vector<float> field(_gridDimensions * _gridDimensions);
+    for (float& value : field)
+    {
+        m_seed = m_seed * 1664525u + 1013904223u;
+        value = _min + (_max - _min) * (float(m_seed >> 8) / 16777216.0f);
+    }
+    return field;
+}
+
+std::vector<float> Validation::ToLayout(const GridLayout& _grid, const std::vector<float>& _field)
+{
+    int gridDimensions = _grid.GetGridDimensions();
+    std::vector<float> field(_grid.GetStorageSize(), 0.0f);
+    for (int j = 0; j < gridDimensions; ++j)
+    {
+        for (int i = 0; i < gridDimensions; ++i)
+        {
+            field[_grid.GetIndex(i, j)] = _field[i + j * gridDimensions];
+        }
+    }
+    return field;
+}
+
+Validation::Error Validation::Compare(const GridLayout& _grid, const std::vector<float>& _field, const std::vector<float>& _reference)
+{
+    int gridDimensions = _grid.GetGridDimensions();
+    double largest = 0.0;
+    double magnitude = 0.0;
+    double difference = 0.0;
+    double norm = 0.0;
+    for (int j = 0; j < gridDimensions; ++j)
+    {
+        for (int i = 0; i < gridDimensions; ++i)
+        {
+            double expected = _reference[i + j * gridDimensions];
+            double error = _field[_grid.GetIndex(i, j)] - expected;
+            largest = std::max(largest, std::fabs(error));
+            magnitude = std::max(magnitude, std::fabs(expected));
+            difference += error * error;
+            norm += expected * expected;
+        }
+    }
+    return {largest / std::max(magnitude, 1.0e-30), std::sqrt(difference / std::max(norm, 1.0e-30))};
+}
+
+double Validation::Divergence(const GridLayout& _grid, const std::vector<float>& _xVel, const std::vector<float>& _yVel)
+{
+    int gridDimensions = _grid.GetGridDimensions();
+    double sum = 0.0;
+    _grid.ForEachCell(1, gridDimensions - 1, [&](int i, int j, int)
+    {
+        double d = 0.5 * (_xVel[_grid.GetIndex(i + 1, j)] - _xVel[_grid.GetIndex(i - 1, j)] +
+                          _yVel[_grid.GetIndex(i, j + 1)] - _yVel[_grid.GetIndex(i, j - 1)]);
+        sum += d * d;
+    });
+    return std::sqrt(sum / (double(gridDimensions - 2) * (gridDimensions - 2)));
+}
+
+double Validation::Total(const GridLayout& _grid, const std::vector<float>& _field)
+{
+    double total = 0.0;
+    _grid.ForEachCell(0, _grid.GetGridDimensions(), [&](int, int, int index)
+    {
+        total += _field[index];
+    });
+    return total;
+}
@@ -2,16 +2,178 @@
 /// @file main.cpp
 /// @brief Program entry, creats SDL context
 
+#include "Benchmark.h"
+#include "Fluid.h"
 #include "SDLScene.h"
+#include "Telemetry.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 int main(int argc, char* args[])
 {
     SDLScene scene;
+    std::string playback;
+    std::string inputReplay;
+    bool headless = false;
+    int volume = 0;
+    std::string telemetryPath;
+    float telemetryRate = Telemetry::m_DEFAULT_RATE;
+
+    // Command line options
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(args[i], "--benchmark") == 0)
+        {
+            // Headless run, no window required
+            int frames = 50;
+            if (i + 1 < argc)
+            {
+                frames = std::atoi(args[i + 1]) > 0 ? std::atoi(args[i + 1]) : frames;
+            }
+            Benchmark benchmark(frames);
+            benchmark.Run();
+            return 0;
+        }
+        else if (std::strcmp(args[i], "--benchmark-3d") == 0)
+        {
+            int frames = 10;
+            if (i + 1 < argc)
+            {
+                frames = std::atoi(args[i + 1]) > 0 ? std::atoi(args[i + 1]) : frames;
+            }
+            Benchmark benchmark(frames);
+            benchmark.RunVolume();
+            return 0;
+        }
+        else if (std::strcmp(args[i], "--volume") == 0 && i + 1 < argc)
+        {
+            volume = std::atoi(args[++i]);
+            if (volume < 8)
+            {
+                std::cout << "Volume resolution must be at least 8\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(args[i], "--layout") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (std::strcmp(args[i], "tiled") == 0)
+            {
+                scene.SetMemoryLayout(MemoryLayout::Tiled);
+            }
+            else if (std::strcmp(args[i], "row-major") == 0)
+            {
+                scene.SetMemoryLayout(MemoryLayout::RowMajor);
+            }
+            else
+            {
+                std::cout << "Unknown layout: " << args[i] << " (expected row-major or tiled)\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(args[i], "--load-snapshot") == 0 && i + 1 < argc)
+        {
+            scene.SetStartupSnapshot(args[++i]);
+        }
+        else if (std::strcmp(args[i], "--obstacles") == 0 && i + 1 < argc)
+        {
+            scene.SetObstacles(args[++i]);
+        }
+        else if (std::strcmp(args[i], "--particles") == 0 && i + 1 < argc)
+        {
+            int capacity = std::atoi(args[++i]);
+            if (capacity < 1)
+            {
+                std::cout << "Particle capacity must be at least 1\n";
+                return 1;
+            }
+            scene.SetParticleCapacity(capacity);
+        }
+        else if (std::strcmp(args[i], "--species") == 0 && i + 1 < argc)
+        {
+            int species = std::atoi(args[++i]);
+            if (species < 1 || species > Fluid::m_MAX_SPECIES)
+            {
+                std::cout << "Species count must be 1 - " << Fluid::m_MAX_SPECIES << "\n";
+                return 1;
+            }
+            scene.SetSpeciesCount(species);
+        }
+        else if (std::strcmp(args[i], "--telemetry") == 0)
+        {
+            // Optional socket path
+            std::string path = "/tmp/fluid-sim.sock";
+            if (i + 1 < argc && args[i + 1][0] != '-')
+            {
+                path = args[++i];
+            }
+            telemetryPath = path;
+        }
+        else if (std::strcmp(args[i], "--telemetry-rate") == 0 && i + 1 < argc)
+        {
+            telemetryRate = float(std::atof(args[++i]));
+            if (telemetryRate <= 0.0f)
+            {
+                std::cout << "Telemetry rate must be above 0\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(args[i], "--capture-velocity") == 0)
+        {
+            scene.SetCaptureVelocity(true);
+        }
+        else if (std::strcmp(args[i], "--play") == 0 && i + 1 < argc)
+        {
+            playback = args[++i];
+        }
+        else if (std::strcmp(args[i], "--record-input") == 0 && i + 1 < argc)
+        {
+            scene.SetInputRecording(args[++i]);
+        }
+        else if (std::strcmp(args[i], "--replay-input") == 0 && i + 1 < argc)
+        {
+            inputReplay = args[++i];
+        }
+        else if (std::strcmp(args[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+    }
+
+    if (!telemetryPath.empty())
+    {
+        scene.SetTelemetry(telemetryPath, telemetryRate);
+    }
+
+    if (!inputReplay.empty())
+    {
+        if (!scene.SetInputReplay(inputReplay))
+        {
+            return 1;
+        }
+        if (headless)
+        {
+            return scene.ReplayInputHeadless() ? 0 : 1;
+        }
+    }
+
     if (scene.Initialise())
     {
-        scene.GameLoop();
+        if (!playback.empty())
+        {
+            scene.PlayRecording(playback);
+        }
+        else if (volume > 0)
+        {
+            scene.VolumeLoop(volume);
+        }
+        else
+        {
+            scene.GameLoop();
+        }
     }
     else
     {
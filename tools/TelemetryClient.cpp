@@ -0,0 +1,92 @@
+///
+/// @file TelemetryClient.cpp
+/// @brief Tails a running fluid-sim's --telemetry socket, printing each JSON line as it arrives
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const char* DEFAULT_PATH = "/tmp/fluid-sim.sock";
+
+    int Connect(const std::string& _path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+
+        int client = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (client >= 0 && connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(client);
+            client = -1;
+        }
+        return client;
+    }
+}
+
+int main(int argc, char* args[])
+{
+    std::string path = DEFAULT_PATH;
+    bool follow = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(args[i], "--follow") == 0 || std::strcmp(args[i], "-f") == 0)
+        {
+            follow = true;
+        }
+        else if (std::strcmp(args[i], "--help") == 0 || std::strcmp(args[i], "-h") == 0)
+        {
+            std::cout << "Usage: fluid-telemetry [-f|--follow] [socket path, default " << DEFAULT_PATH << "]\n"
+                      << "  --follow  wait for the simulator to start, and reconnect when it restarts\n";
+            return 0;
+        }
+        else
+        {
+            path = args[i];
+        }
+    }
+    if (path.size() >= sizeof(sockaddr_un::sun_path))
+    {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+
+    while (true)
+    {
+        int client = Connect(path);
+        if (client < 0)
+        {
+            if (!follow)
+            {
+                std::cerr << "Failed to connect to " << path << ": " << std::strerror(errno) << "\n";
+                return 1;
+            }
+            sleep(1);
+            continue;
+        }
+
+        // The simulator only writes whole lines, so the stream can be passed straight through
+        char buffer[4096];
+        ssize_t received;
+        while ((received = read(client, buffer, sizeof(buffer))) > 0)
+        {
+            std::fwrite(buffer, 1, size_t(received), stdout);
+            std::fflush(stdout);
+        }
+        close(client);
+
+        if (!follow)
+        {
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,19 @@
+///
+/// @file Validate.cpp
+/// @brief Validation entry point, checks the optimised solver kernels against the reference solver (run by CTest)
+
+#include "Validation.h"
+
+#include <cstdlib>
+
+int main(int argc, char* args[])
+{
+    // Optional seed for the randomised fields
+    uint32_t seed = 1;
+    if (argc > 1 && std::atoi(args[1]) > 0)
+    {
+        seed = uint32_t(std::atoi(args[1]));
+    }
+    Validation validation(seed);
+    return validation.Run() ? 0 : 1;
+}